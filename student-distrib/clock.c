@@ -0,0 +1,112 @@
+#include "clock.h"
+#include "lib.h"
+#include "drivers/pit.h"
+#include "drivers/rtc.h"
+
+static uint32_t tsc_khz = FALLBACK_TSC_KHZ;
+static uint64_t boot_tsc = 0;
+static uint32_t boot_time = 0;
+
+/*
+ * clock_init
+ * DESCRIPTION: Times a few PIT one-shots with the TSC and keeps the fastest,
+ * since an SMI or a slow port read can only make a run look longer. Then
+ * stamps the TSC and the CMOS wall clock as the start of both clocks
+ * INPUTS: none
+ * SIDE EFFECTS: busy waits about CALIBRATE_RUNS * CALIBRATE_MS, call with interrupts off
+ * RETURN VALUE: none
+ */
+void clock_init() {
+	uint32_t best = 0, cycles;
+	int i;
+
+	for (i = 0; i < CALIBRATE_RUNS; i++) {
+		cycles = pit_time_tsc(CALIBRATE_MS);
+		if (cycles != 0 && (best == 0 || cycles < best))
+			best = cycles;
+	}
+	if (best != 0)
+		tsc_khz = best / CALIBRATE_MS;
+	boot_time = rtc_wall_clock();
+	boot_tsc = rdtsc();
+}
+
+/*
+ * clock_tsc_khz
+ * DESCRIPTION: Calibrated TSC rate
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: TSC cycles per ms
+ */
+uint32_t clock_tsc_khz() {
+	return tsc_khz;
+}
+
+/*
+ * clock_cycles_to_ns
+ * DESCRIPTION: Converts in two 64 by 32 bit divides, whole ms and then the
+ * leftover cycles, so the multiply by 10^6 cannot overflow
+ * INPUTS: cycles: TSC cycles
+ * SIDE EFFECTS: none
+ * RETURN VALUE: ns
+ */
+uint64_t clock_cycles_to_ns(uint64_t cycles) {
+	uint64_t ms = cycles, part;
+
+	part = (uint64_t) div64_32(&ms, tsc_khz) * NS_PER_MS;
+	div64_32(&part, tsc_khz);
+	return ms * NS_PER_MS + part;
+}
+
+/*
+ * clock_ns
+ * DESCRIPTION: Monotonic time, as cheap as a TSC read and two divides
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: ns since clock_init
+ */
+uint64_t clock_ns() {
+	return clock_cycles_to_ns(rdtsc() - boot_tsc);
+}
+
+/*
+ * clock_boot_tsc
+ * DESCRIPTION: Start of the monotonic clock
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: TSC at clock_init
+ */
+uint64_t clock_boot_tsc() {
+	return boot_tsc;
+}
+
+/*
+ * clock_boot_time
+ * DESCRIPTION: CMOS wall clock when the kernel booted
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: seconds since 1970 UTC
+ */
+uint32_t clock_boot_time() {
+	return boot_time;
+}
+
+/*
+ * clock_gettime
+ * DESCRIPTION: Reads a clock. The wall clock is the CMOS time at boot moved
+ * on by the TSC, the CMOS is not read again
+ * INPUTS: id: CLOCK_MONOTONIC or CLOCK_REALTIME, ts: where to put the time
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 0 on success, -1 for an unknown clock
+ */
+int32_t clock_gettime(uint32_t id, timespec_t* ts) {
+	uint64_t now = clock_ns();
+
+	if (id != CLOCK_MONOTONIC && id != CLOCK_REALTIME)
+		return -1;
+	ts->nsec = div64_32(&now, NS_PER_SEC);
+	ts->sec = (uint32_t) now;
+	if (id == CLOCK_REALTIME)
+		ts->sec += boot_time;
+	return 0;
+}
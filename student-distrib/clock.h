@@ -0,0 +1,40 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "types.h"
+
+#define CLOCK_MONOTONIC 0 // time since boot
+#define CLOCK_REALTIME 1  // wall clock, seconds since 1970 UTC
+#define CALIBRATE_MS 50
+#define CALIBRATE_RUNS 3
+#define FALLBACK_TSC_KHZ 1000000 // if the PIT never finishes, guess 1 GHz
+#define NS_PER_MS 1000000
+#define NS_PER_SEC 1000000000
+
+typedef struct timespec {
+	uint32_t sec;
+	uint32_t nsec;
+} timespec_t;
+
+// calibrate the TSC against the PIT and read the CMOS clock, call with interrupts off
+void clock_init();
+
+// TSC cycles per ms
+uint32_t clock_tsc_khz();
+
+// TSC cycles to ns
+uint64_t clock_cycles_to_ns(uint64_t cycles);
+
+// ns since clock_init
+uint64_t clock_ns();
+
+// TSC at clock_init, where CLOCK_MONOTONIC starts
+uint64_t clock_boot_tsc();
+
+// wall clock at clock_init, seconds since 1970 UTC
+uint32_t clock_boot_time();
+
+// time on a CLOCK_* clock
+int32_t clock_gettime(uint32_t id, timespec_t* ts);
+
+#endif // CLOCK_H
@@ -10,6 +10,57 @@ static inode_t * inode_start;
 static void * data_start;
 static uint32_t inode_count;
 static void * filesys_end;
+static dentry_hash_slot_t dentry_hash_table[DENTRY_HASH_SIZE];
+static extent_t extent_pool[MAX_EXTENTS];
+static uint32_t inode_extent_start[MAX_INODES];
+// 0 means the inode did not fit in extent_pool and uses the per block path
+static uint32_t inode_extent_count[MAX_INODES];
+
+/*
+ * dentry_name_hash
+ * DESCRIPTION: FNV-1a hash of a filename, stops at NUL or FILESYSTEM_NAME_MAX chars
+ * so names that fill the whole dentry hash the same as the lookup string
+ * INPUTS: fname: filename to hash
+ * SIDE EFFECTS: NONE
+ * RETURN VALUE: 32 bit hash of the name
+ */
+static uint32_t dentry_name_hash(const int8_t* fname) {
+	uint32_t hash = FNV_OFFSET_BASIS;
+	int i;
+	for (i = 0; i < FILESYSTEM_NAME_MAX && fname[i] != '\0'; i++) {
+		hash ^= (uint8_t) fname[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+/*
+ * dentry_hash_build
+ * DESCRIPTION: Indexes every directory entry by filename (linear probing)
+ * INPUTS: none
+ * SIDE EFFECTS: Fills dentry_hash_table
+ * RETURN VALUE: none
+ */
+static void dentry_hash_build(void) {
+	uint32_t index, dir_count, hash, slot;
+
+	for (slot = 0; slot < DENTRY_HASH_SIZE; slot++)
+		dentry_hash_table[slot].index = DENTRY_HASH_EMPTY;
+
+	dir_count = (uint32_t) filesys->dir_count;
+	if (dir_count > MAX_DENTRIES)
+		dir_count = MAX_DENTRIES;
+
+	// inserting in directory order keeps the first of any duplicate names reachable first
+	for (index = 0; index < dir_count; index++) {
+		hash = dentry_name_hash(filesys->direntries[index].filename);
+		slot = hash & DENTRY_HASH_MASK;
+		while (dentry_hash_table[slot].index != DENTRY_HASH_EMPTY)
+			slot = (slot + 1) & DENTRY_HASH_MASK;
+		dentry_hash_table[slot].hash = hash;
+		dentry_hash_table[slot].index = index;
+	}
+}
 
 /*
  * file_open
@@ -138,6 +189,88 @@ int32_t dir_write(uint32_t fd, const void* buf, int32_t nbytes) {
 	return -1;
 }
 
+/*
+ * extent_build
+ * DESCRIPTION: Splits every inode's block list into runs of consecutive data blocks
+ * INPUTS: none
+ * SIDE EFFECTS: Fills extent_pool, inode_extent_start and inode_extent_count
+ * RETURN VALUE: none
+ */
+static void extent_build(void) {
+	uint32_t inode, block, blocks, used = 0;
+	uint32_t first = 0;
+	inode_t * inode_cur;
+	extent_t * run;
+
+	for (inode = 0; inode < inode_count && inode < MAX_INODES; inode++) {
+		inode_cur = inode_start + inode;
+		inode_extent_start[inode] = used;
+		inode_extent_count[inode] = 0;
+
+		blocks = ((uint32_t) inode_cur->length + OFFSET_MASK) >> OFFSET_SHIFT;
+		if (blocks > MAX_FILE_BLOCKS)
+			continue;
+
+		first = used;
+		run = NULL;
+		for (block = 0; block < blocks; block++) {
+			// extend the current run while the next data block follows it
+			if (run && (uint32_t) inode_cur->data_block_num[block] == run->data_block + run->count) {
+				run->count++;
+				continue;
+			}
+			if (used == MAX_EXTENTS)
+				break;
+			run = &extent_pool[used++];
+			run->file_block = block;
+			run->data_block = inode_cur->data_block_num[block];
+			run->count = 1;
+		}
+
+		// pool ran out mid file, give the space back and fall back to per block reads
+		if (block != blocks) {
+			used = first;
+			continue;
+		}
+		inode_extent_count[inode] = used - first;
+	}
+}
+
+/*
+ * read_data_extents
+ * DESCRIPTION: Copies file data one contiguous run at a time
+ * INPUTS:
+ * inode: Inode to get data from (must have extents)
+ * offset: where in file to read from
+ * buf: buffer to copy from file to
+ * length: number of bytes to copy, already clipped to the file length
+ * SIDE EFFECTS: Fills buffer with length bytes of file starting at offset
+ * RETURN VALUE: none
+ */
+static void read_data_extents(uint32_t inode, uint32_t offset, void* buf, uint32_t length) {
+	extent_t * run = &extent_pool[inode_extent_start[inode]];
+	extent_t * last = run + inode_extent_count[inode];
+	uint32_t block = offset >> OFFSET_SHIFT;
+	uint32_t in_run, avail, copy_size;
+	uint32_t buffer_offset = 0;
+
+	// runs are sorted by file_block, find the one holding offset
+	while (run < last && block >= run->file_block + run->count)
+		run++;
+
+	for ( ; length && run < last; run++) {
+		in_run = block - run->file_block;
+		avail = ((run->count - in_run) << OFFSET_SHIFT) - (offset & OFFSET_MASK);
+		copy_size = length < avail ? length : avail;
+		memcpy(buf + buffer_offset,
+			data_start + ((run->data_block + in_run) << OFFSET_SHIFT) + (offset & OFFSET_MASK), copy_size);
+		buffer_offset += copy_size;
+		offset += copy_size;
+		length -= copy_size;
+		block = offset >> OFFSET_SHIFT;
+	}
+}
+
 /*
  * filesystem_init
  * DESCRIPTION: Intializes global variables which represent filesystem
@@ -158,40 +291,42 @@ int32_t filesystem_init (uint32_t file_start, uint32_t file_end) {
 	if (!file_start || !file_end)
 		return -1;
 
+	// filesystem is read only, so the name index never needs rebuilding
+	dentry_hash_build();
+	extent_build();
+
 	return 0;
 }
 
 /*
  * read_dentry_by_name
- * DESCRIPTION: given string returns dentry that has the inode
+ * DESCRIPTION: given string returns dentry that has the inode, looked up through
+ * the hashed name index. A missing name stops at the first empty slot, so
+ * misses cost the same handful of probes as hits.
  * INPUTS:
  * fname: string of filename
  * dentry: pointer to dentry to modify with inode
  * SIDE EFFECTS: Modifies dentry with new inode
- * RETURN VALUE: 0 or -1 iff NULL input
+ * RETURN VALUE: 0 or -1 iff NULL input or no such file
  */
 int32_t read_dentry_by_name (const uint8_t* fname, dentry_t* dentry) {
 	if (!fname || !dentry)
 		return -1;
-	uint32_t index;
-	unsigned char found = 0;
-	// 63 is number of files in the system
-	for (index = 0; index < 63; index++) {
-		char * filename = filesys->direntries[index].filename;
-		if (!filename)
-			continue;
-		else if (!strncmp((char *) fname, filename, 32)) { // 32 bytes being compared
-			found = 1;
-			break;
+	uint32_t hash = dentry_name_hash((const int8_t *) fname);
+	uint32_t slot = hash & DENTRY_HASH_MASK;
+	int32_t index;
+
+	while ((index = dentry_hash_table[slot].index) != DENTRY_HASH_EMPTY) {
+		// only run the 32 byte compare when the full hash already matches
+		if (dentry_hash_table[slot].hash == hash &&
+			!strncmp((char *) fname, filesys->direntries[index].filename, FILESYSTEM_NAME_MAX)) {
+			read_dentry_by_index(index, dentry);
+			return 0;
 		}
+		slot = (slot + 1) & DENTRY_HASH_MASK;
 	}
-	if (!found) {
-		// printf("Cannot find file by that name!\n");
-		return -1;
-	}
-	// printf("Index is: %d\n", index);
-	read_dentry_by_index(index, dentry);
-	return 0;
+	// printf("Cannot find file by that name!\n");
+	return -1;
 }
 
 /*
@@ -222,17 +357,19 @@ int32_t read_dentry_by_index (uint32_t index, dentry_t* dentry) {
 }
 
 /*
- * read_data
- * DESCRIPTION: Reads file of Inode assuming it is on disk
+ * read_data_path
+ * DESCRIPTION: Reads file of Inode assuming it is on disk, through the extents
+ * when the inode has them and use_extents is set, one block at a time otherwise
  * INPUTS:
  * inode: Inode to get data from
  * offset: where in file to read from
  * buf: buffer to copy from file to
  * nbytes: number of bytes to copy
+ * use_extents: 0 forces the per block path
  * SIDE EFFECTS: Fills buffer with nbytes of file starting at last position
  * RETURN VALUE: number of bytes read or -1 iff NULL input
  */
-int32_t read_data (uint32_t inode, uint32_t offset, void* buf, uint32_t length) {
+static int32_t read_data_path (uint32_t inode, uint32_t offset, void* buf, uint32_t length, int use_extents) {
 	int32_t bytes_to_read = 0;
 
 	if (!buf) {
@@ -255,6 +392,12 @@ int32_t read_data (uint32_t inode, uint32_t offset, void* buf, uint32_t length)
 	}
 	bytes_to_read = length;
 
+	/* Serve whole runs of consecutive blocks with a single copy each */
+	if (use_extents && inode < MAX_INODES && inode_extent_count[inode]) {
+		read_data_extents(inode, offset, buf, length);
+		return bytes_to_read;
+	}
+
 	/* Start at offset */
 	int cur_block_num = inode_cur->data_block_num[offset >> OFFSET_SHIFT];
 	int buffer_offset = 0;
@@ -290,6 +433,33 @@ int32_t read_data (uint32_t inode, uint32_t offset, void* buf, uint32_t length)
 	return bytes_to_read;
 }
 
+/*
+ * read_data
+ * DESCRIPTION: Reads file of Inode assuming it is on disk
+ * INPUTS:
+ * inode: Inode to get data from
+ * offset: where in file to read from
+ * buf: buffer to copy from file to
+ * nbytes: number of bytes to copy
+ * SIDE EFFECTS: Fills buffer with nbytes of file starting at last position
+ * RETURN VALUE: number of bytes read or -1 iff NULL input
+ */
+int32_t read_data (uint32_t inode, uint32_t offset, void* buf, uint32_t length) {
+	return read_data_path(inode, offset, buf, length, 1);
+}
+
+/*
+ * read_data_blocks
+ * DESCRIPTION: read_data without the extents, one copy per block. Reference
+ * the extent path is checked and timed against
+ * INPUTS: as read_data
+ * SIDE EFFECTS: Fills buffer with nbytes of file starting at offset
+ * RETURN VALUE: number of bytes read or -1 iff NULL input
+ */
+int32_t read_data_blocks (uint32_t inode, uint32_t offset, void* buf, uint32_t length) {
+	return read_data_path(inode, offset, buf, length, 0);
+}
+
 /*
  * read_inode_size
  * DESCRIPTION: Reads file of Inode assuming it is on disk
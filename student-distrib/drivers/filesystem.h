@@ -10,6 +10,19 @@
 #define OFFSET_SHIFT 12
 
 #define FILESYSTEM_NAME_MAX 32
+#define MAX_DENTRIES 63
+
+// open addressed name index, kept at least half empty so probes stay short
+#define DENTRY_HASH_SIZE 128
+#define DENTRY_HASH_MASK (DENTRY_HASH_SIZE - 1)
+#define DENTRY_HASH_EMPTY -1
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+// contiguous block runs, precomputed per inode for read_data
+#define MAX_INODES 64
+#define MAX_EXTENTS 1024
+#define MAX_FILE_BLOCKS 1023
 
 typedef struct dentry {
 	int8_t filename[32];
@@ -20,17 +33,28 @@ typedef struct dentry {
 
 typedef struct inode {
 	int32_t length;
-	int32_t data_block_num[1023];
+	int32_t data_block_num[MAX_FILE_BLOCKS];
 } inode_t;
 
+typedef struct extent {
+	uint32_t file_block; // first block index within the file
+	uint32_t data_block; // data block number backing file_block
+	uint32_t count;      // number of consecutive blocks in the run
+} extent_t;
+
 typedef struct boot_block {
 	int32_t dir_count;
 	int32_t inode_count;
 	int32_t data_count;
 	int8_t reserved[52];
-	dentry_t direntries[63];
+	dentry_t direntries[MAX_DENTRIES];
 } boot_block_t;
 
+typedef struct dentry_hash_slot {
+	uint32_t hash;
+	int32_t index; // index into direntries or DENTRY_HASH_EMPTY
+} dentry_hash_slot_t;
+
 int32_t file_open(const uint8_t * fname);
 int32_t file_close(uint32_t fd);
 int32_t file_read (uint32_t fd, void* buf, int32_t nbytes);
@@ -45,6 +69,7 @@ int32_t filesystem_init (uint32_t file_start, uint32_t file_end);
 int32_t read_dentry_by_name (const uint8_t* fname, dentry_t* dentry);
 int32_t read_dentry_by_index (uint32_t index, dentry_t* dentry);
 int32_t read_data (uint32_t inode, uint32_t offset, void* buf, uint32_t length);
+int32_t read_data_blocks (uint32_t inode, uint32_t offset, void* buf, uint32_t length);
 int32_t read_inode_size (uint32_t inode);
 
 #endif
@@ -8,6 +8,8 @@
 #include "../spinlock.h"
 #include "../i8259.h"
 #include "../paging.h"
+#include "../kmalloc.h"
+#include "../wait.h"
 
 /* Handles keyboard buffer in interrupt context */
 static void keyboard_handle_interrupt_buffer(uint8_t scan_code);
@@ -26,6 +28,8 @@ static uint8_t terminal_mode = 0;
 /* Current len of buffer (current idx is keyboard_buffer_len-1) */
 static char keyboard_buffers[3][BUF_LEN] = {{0x00}};
 static uint8_t keyboard_buffer_lens[3] = {0x00};
+// terminal_read sleeps here until its terminal's line is entered
+static wait_queue_t line_waits[3] = { WAIT_QUEUE_INIT, WAIT_QUEUE_INIT, WAIT_QUEUE_INIT };
 
 /*
  * keyboard_init
@@ -210,6 +214,7 @@ void keyboard_handle_interrupt_buffer(uint8_t scan_code){
 		keyboard_buffers[term_num][keyboard_buffer_lens[term_num]] = current;
 		keyboard_buffer_lens[term_num]++;
 		putc('\n');
+		wake_up(&line_waits[term_num]);
 	}
 	// Control L Clears Screen and rewrites terminal
 	else if (control_flag == 1 && scan_code == 0x26){
@@ -224,6 +229,25 @@ void keyboard_handle_interrupt_buffer(uint8_t scan_code){
 			putc_colourised(keyboard_buffers[term_num][i], YELLOW);
 		}
 	}
+	// Control P prints each process' resident memory and CPU usage, Control K the kernel heap, then rewrites the line
+	else if (control_flag == 1 && (scan_code == 0x19 || scan_code == 0x25)){
+		putc('\n');
+		if (scan_code == 0x19) {
+			print_resident_report();
+			print_cpu_usage();
+		} else {
+			kmem_print_stats();
+		}
+
+		// reprint "391OS> "
+		for (i = 0; i < sizeof(prompt); i++) {
+			putc_colourised(prompt[i], WHITE);
+		}
+		// reprint all chars in buffer
+		for (i = 0; i < keyboard_buffer_lens[term_num]; i++){
+			putc_colourised(keyboard_buffers[term_num][i], YELLOW);
+		}
+	}
 	// Checks for backspace
 	else if (scan_code == 0x0E && keyboard_buffer_lens[term_num] > 0){
 		// Tab is three spaces
@@ -381,6 +405,24 @@ void reset_term_keyboard_buffer(){
 	keyboard_buffer_lens[term_num] = 0;
 }
 
+/*
+ * wait_proc_keyboard_line
+ * DESCRIPTION: Sleeps until the current task's terminal has a full line (ending
+ * in a newline) in its keyboard buffer
+ * INPUTS: None
+ * SIDE EFFECTS: the task is off the run queue while it waits
+ * RETURN VALUE: None
+ */
+void wait_proc_keyboard_line(){
+	int term = running_proc;
+
+	cli();
+	while (keyboard_buffer_lens[term] == 0 || keyboard_buffers[term][keyboard_buffer_lens[term]-1] != '\n') {
+		sleep_on(&line_waits[term]);
+	}
+	sti();
+}
+
 /*
  * reset_keyboard_buffer
  * DESCRIPTION: Empty keyboard buffer and changing keyboard_buffer_lens[term_num] to 0
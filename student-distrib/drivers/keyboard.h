@@ -39,6 +39,9 @@ uint8_t get_proc_keyboard_buffer_length();
 /* Returns the term buffer's current length */
 uint8_t get_term_keyboard_buffer_length();
 
+/* Sleeps until the proc's terminal has a full line */
+void wait_proc_keyboard_line();
+
 /* Resets the keyboard buffer (usually after a new line) */
 void reset_term_keyboard_buffer();
 void reset_proc_keyboard_buffer();
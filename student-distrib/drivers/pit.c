@@ -5,7 +5,7 @@
 #include "../spinlock.h"
 #include "../i8259.h"
 #include "../fd.h"
-#include "../scheduling.h"
+#include "../timer.h"
 
 /*
  * pit_init
@@ -35,14 +35,83 @@ void pit_init(uint32_t freq) {
 	return;
 }
 
+/*
+ * pit_oneshot
+ * DESCRIPTION: Programs channel 0 to interrupt once, count cycles from now
+ * INPUTS: count: PIT cycles, 1 to PIT_MAX_COUNT
+ * SIDE EFFECTS: replaces whatever the channel was counting
+ * RETURN VALUE: none
+ */
+void pit_oneshot(uint16_t count) {
+	outb(CMD_ONESHOT, CMD_PORT);
+	outb((uint8_t)(count & 0xFF), PIT_PORT);
+	outb((uint8_t)((count >> 8) & 0xFF), PIT_PORT);
+}
+
+/*
+ * pit_stop
+ * DESCRIPTION: Cancels a pending one-shot, writing the mode stops the count
+ * until a new one is loaded
+ * INPUTS: none
+ * SIDE EFFECTS: no PIT interrupt until the next pit_oneshot
+ * RETURN VALUE: none
+ */
+void pit_stop(void) {
+	outb(CMD_ONESHOT, CMD_PORT);
+}
+
+/*
+ * pit_read_count
+ * DESCRIPTION: Latches and reads channel 0's count
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: cycles left before the one-shot fires
+ */
+uint16_t pit_read_count(void) {
+	uint8_t lo, hi;
+
+	outb(CMD_LATCH, CMD_PORT);
+	lo = inb(PIT_PORT);
+	hi = inb(PIT_PORT);
+	return ((uint16_t) hi << 8) | lo;
+}
+
+/*
+ * pit_time_tsc
+ * DESCRIPTION: Times a one-shot on channel 2 with the TSC. Channel 2 has no
+ * interrupt, so this polls its output bit and leaves channel 0 alone. The
+ * speaker stays off
+ * INPUTS: ms: length, at most PIT_MAX_COUNT cycles (54 ms)
+ * SIDE EFFECTS: busy waits for ms, call with interrupts off
+ * RETURN VALUE: TSC cycles the one-shot took, 0 if it never ran out
+ */
+uint32_t pit_time_tsc(uint32_t ms) {
+	uint32_t count = MAX_PIT_FREQ * ms / 1000, polls;
+	uint64_t start;
+
+	if (count > PIT_MAX_COUNT)
+		count = PIT_MAX_COUNT;
+	outb((inb(GATE_PORT) & ~GATE_SPEAKER) | GATE_CH2, GATE_PORT);
+	outb(CMD_CH2_ONESHOT, CMD_PORT);
+	outb((uint8_t)(count & 0xFF), PIT_CH2_PORT);
+	outb((uint8_t)((count >> 8) & 0xFF), PIT_CH2_PORT);
+
+	start = rdtsc();
+	for (polls = 0; polls < CALIBRATE_POLLS; polls++) {
+		if (inb(GATE_PORT) & GATE_OUT2)
+			return (uint32_t) (rdtsc() - start);
+	}
+	return 0;
+}
+
 /*
  * pit_handle_interrupt
  * DESCRIPTION: Handle the PIT interrupt
  * INPUTS: none
- * SIDE EFFECTS: none
+ * SIDE EFFECTS: passes the one-shot's expiry to the timer
  * RETURN VALUE: none
  */
 void pit_handle_interrupt(void) {
 	send_eoi(PIT_IRQ);
-	context_switch();
+	timer_interrupt();
 }
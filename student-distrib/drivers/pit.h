@@ -12,10 +12,32 @@
 #define CMD_PORT 0x43
 #define PIT_PORT 0x40
 #define CMD_NUM 0x36
+#define CMD_ONESHOT 0x30 // channel 0, lobyte/hibyte, interrupt on terminal count
+#define CMD_LATCH 0x00 // channel 0, latch the count for reading
+#define PIT_MAX_COUNT 0xFFFF
+#define PIT_CH2_PORT 0x42
+#define CMD_CH2_ONESHOT 0xB0 // channel 2, lobyte/hibyte, interrupt on terminal count
+#define GATE_PORT 0x61 // bit 0 gates channel 2, bit 1 the speaker, bit 5 is channel 2's output
+#define GATE_CH2 0x01
+#define GATE_SPEAKER 0x02
+#define GATE_OUT2 0x20
+#define CALIBRATE_POLLS 0x1000000
 
 /* Initialize the PIT */
 void pit_init(uint32_t freq);
 
+/* Interrupt once after count PIT cycles */
+void pit_oneshot(uint16_t count);
+
+/* Cancel a one-shot that has not fired */
+void pit_stop(void);
+
+/* PIT cycles left in the current one-shot */
+uint16_t pit_read_count(void);
+
+/* TSC cycles in ms of PIT channel 2 time, 0 if the PIT never finished */
+uint32_t pit_time_tsc(uint32_t ms);
+
 /* Handle the PIT interrupt */
 void pit_handle_interrupt(void);
 
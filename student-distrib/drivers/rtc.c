@@ -9,10 +9,13 @@
 #include "../fd.h"
 #include "../x86_desc.h"
 #include "../scheduling.h"
+#include "../wait.h"
 
 /* static spinlock_t rtc_lock = SPIN_LOCK_UNLOCKED; */
 
 volatile int flag[3];
+// rtc_read sleeps here until its terminal's virtual tick
+static wait_queue_t rtc_waits[3] = { WAIT_QUEUE_INIT, WAIT_QUEUE_INIT, WAIT_QUEUE_INIT };
 
 /*
  * rtc_init
@@ -73,6 +76,96 @@ void rtc_init(void) {
     // spin_unlock_irq(&rtc_lock);
 }
 
+/*
+ * cmos_read
+ * DESCRIPTION: Reads a CMOS register
+ * INPUTS: reg: register, with the NMI disable bit
+ * SIDE EFFECTS: leaves NMI disabled
+ * RETURN VALUE: register value
+ */
+static uint8_t cmos_read(uint8_t reg) {
+    outb(reg, PORT1);
+    return inb(PORT2);
+}
+
+/*
+ * rtc_read_fields
+ * DESCRIPTION: Reads the clock registers once an update is not in progress
+ * INPUTS: f: sec, min, hour, day, month, year
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+static void rtc_read_fields(uint8_t f[6]) {
+    while (cmos_read(REGA) & REGA_UIP)
+        ;
+    f[0] = cmos_read(REG_SEC);
+    f[1] = cmos_read(REG_MIN);
+    f[2] = cmos_read(REG_HOUR);
+    f[3] = cmos_read(REG_DAY);
+    f[4] = cmos_read(REG_MONTH);
+    f[5] = cmos_read(REG_YEAR);
+}
+
+/*
+ * days_from_civil
+ * DESCRIPTION: Counts days in the civil calendar, with March as the first
+ * month so the leap day comes last in its year. Differences give day counts
+ * INPUTS: year, month (1 to 12), day (1 to 31)
+ * SIDE EFFECTS: none
+ * RETURN VALUE: days since 0000-03-01
+ */
+static uint32_t days_from_civil(uint32_t year, uint32_t month, uint32_t day) {
+    if (month <= 2) {
+        year--;
+        month += 12;
+    }
+    return 365 * year + year / 4 - year / 100 + year / 400 + (153 * (month - 3) + 2) / 5 + day - 1;
+}
+
+/*
+ * rtc_wall_clock
+ * DESCRIPTION: Reads the CMOS date and time, assumed to be UTC. It is read
+ * until two reads agree so a tick between registers is not seen, then
+ * converted from BCD and 12 hour time if the CMOS uses them
+ * INPUTS: none
+ * SIDE EFFECTS: busy waits up to about a second for the update to finish
+ * RETURN VALUE: seconds since EPOCH_YEAR-01-01 00:00:00
+ */
+uint32_t rtc_wall_clock(void) {
+    uint8_t f[6], last[6], regb, pm;
+    uint32_t flags, year, days;
+    int i, same;
+
+    cli_and_save(flags);
+    rtc_read_fields(f);
+    do {
+        memcpy(last, f, sizeof(f));
+        rtc_read_fields(f);
+        for (i = 0, same = 1; i < 6; i++)
+            same &= (last[i] == f[i]);
+    } while (!same);
+    regb = cmos_read(REGB);
+    outb(inb(PORT1) & RNMI, PORT1);
+    restore_flags(flags);
+
+    pm = f[2] & HOUR_PM;
+    f[2] &= ~HOUR_PM;
+    if (!(regb & REGB_BINARY)) {
+        for (i = 0; i < 6; i++)
+            f[i] = (f[i] & 0x0F) + (f[i] >> 4) * 10;
+    }
+    if (!(regb & REGB_24H)) {
+        // 12 AM is hour 0, 12 PM is hour 12
+        f[2] %= 12;
+        if (pm)
+            f[2] += 12;
+    }
+
+    year = f[5] + ((f[5] < CENTURY_PIVOT) ? 2000 : 1900);
+    days = days_from_civil(year, f[4], f[3]) - days_from_civil(EPOCH_YEAR, 1, 1);
+    return ((days * 24 + f[2]) * 60 + f[1]) * 60 + f[0];
+}
+
 /*
  * rtc_handle_interrupt
  * DESCRIPTION: Handle the RTC interrupt
@@ -98,6 +191,7 @@ void rtc_handle_interrupt(void) {
         } else {
             counters[i] = FREQ_MAX/frequency[i];
             flag[i] = 0;
+            wake_up(&rtc_waits[i]);
             count--;
         }
     }
@@ -137,15 +231,18 @@ int32_t rtc_close(uint32_t fd) {
  * rtc_read
  * DESCRIPTION:  reads data from RTC
  * INPUTS: none
- * SIDE EFFECTS: does not return until interrupt handler handled
+ * SIDE EFFECTS: sleeps until the interrupt handler ticks this terminal's rate
  * RETURN VALUE: 0
  */
 int32_t rtc_read(uint32_t fd, void* buf, int32_t nbytes) {
-    
-    flag[running_proc] = 1;
-    while ((flag[running_proc] != 0)){
-        continue;
+    int term = running_proc;
+
+    cli();
+    flag[term] = 1;
+    while ((flag[term] != 0)){
+        sleep_on(&rtc_waits[term]);
     }
+    sti();
     return 0;
 }
 
@@ -16,6 +16,20 @@
 #define RNMI 0x7F
 #define RTC_IRQ 8
 
+// CMOS clock registers, selected with NMI disabled like REGA and REGB
+#define REG_SEC 0x80
+#define REG_MIN 0x82
+#define REG_HOUR 0x84
+#define REG_DAY 0x87
+#define REG_MONTH 0x88
+#define REG_YEAR 0x89
+#define REGA_UIP 0x80 // an update is in progress, the clock registers may be torn
+#define REGB_24H 0x02
+#define REGB_BINARY 0x04
+#define HOUR_PM 0x80
+#define EPOCH_YEAR 1970
+#define CENTURY_PIVOT 70 // two digit years below this are 20xx
+
 #define FREQ_ST 512
 #define FREQ_MAX 512
 #define RT_MAX 7
@@ -33,6 +47,9 @@ int print_flag;
 /* Initialize the RTC */
 void rtc_init(void);
 
+/* Wall clock from the CMOS, seconds since 1970 UTC */
+uint32_t rtc_wall_clock(void);
+
 /* Handle the RTC interrupt */
 void rtc_handle_interrupt(void);
 
@@ -37,14 +37,10 @@ int32_t terminal_close(uint32_t fd) {
 int32_t terminal_read(uint32_t fd, void* buf, int32_t nbytes) {
     if (buf == NULL) // null check
         return -1;
-    nbytes = 0;
-    // hold until there is a new line char
-    while(1){
-        nbytes = (int32_t) get_proc_keyboard_buffer_length();
-        get_proc_keyboard_buffer((char *)buf);
-        if(nbytes > 0 && ((char *)buf)[nbytes-1] == '\n')
-            break;
-    }
+    // sleep until there is a new line char
+    wait_proc_keyboard_line();
+    nbytes = (int32_t) get_proc_keyboard_buffer_length();
+    get_proc_keyboard_buffer((char *)buf);
     reset_proc_keyboard_buffer(); // ENTER pressed reset buf
     return nbytes;
 }
@@ -57,19 +53,13 @@ int32_t terminal_read(uint32_t fd, void* buf, int32_t nbytes) {
  * RETURN VALUE: number of bytes written or -1
  */
 int32_t terminal_write(uint32_t fd, const void* buf, int32_t nbytes) {
-    cli();
-    int i;
-    int bytes = 0;
+    int bytes;
     if (buf == NULL) // null check
         return -1;
-        
-    // iterate through keyboard buffer and print character to screen
-    for (i = 0; i < nbytes; i++) {
-        if ( ((char *) buf)[i] != NULL ) {
-            putc_colourised( ((char *) buf)[i], LT_GREEN );
-            bytes++; // byte written
-        }
-    }
+
+    // print the whole buffer, the cursor only moves once at the end
+    cli();
+    bytes = putbuf_colourised((const uint8_t *) buf, nbytes, LT_GREEN);
     sti();
     return bytes;
 }
@@ -1,6 +1,8 @@
 #ifndef FILEDESC
 #define FILEDESC
 
+struct pipe;
+
 typedef struct fd_ops {
 	int32_t (*read) (uint32_t fd, void* buf, int32_t nbytes);
 	int32_t (*write) (uint32_t fds, const void* buf, int32_t nbytes);
@@ -12,6 +14,7 @@ typedef struct fd {
 	fd_ops_t table_pointer;
 	int32_t inode_num;
 	int32_t file_position;
+	struct pipe* pipe; // pipe ends only, see pipe.c
 
 	// most significant bit indicates active if 1
 	int32_t flags;
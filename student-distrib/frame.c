@@ -0,0 +1,199 @@
+#include "frame.h"
+#include "lib.h"
+
+#define FRAME_FREE 0x80 // set in frame_state of the first frame of a free block
+#define LIST_END 0xFFFF
+#define MBI_MEM_VALID 0x01
+#define MBI_MMAP_VALID 0x40
+#define LOW_MEM_END 0x100000
+
+// per frame: FRAME_FREE | order for the head of a free block, 0 otherwise
+static uint8_t frame_state[FRAME_COUNT];
+// doubly linked free lists, one per order, indexed by frame number
+static uint16_t frame_next[FRAME_COUNT];
+static uint16_t frame_prev[FRAME_COUNT];
+static uint16_t free_lists[MAX_FRAME_ORDER + 1];
+static uint32_t free_frames = 0;
+static uint32_t managed_top = FRAME_BASE;
+
+/*
+ * list_push
+ * DESCRIPTION: puts a free block at the head of its order's free list
+ * INPUTS: order: block order, idx: first frame of the block
+ * SIDE EFFECTS: marks the block free
+ * RETURN VALUE: none
+ */
+static void list_push(uint32_t order, uint32_t idx) {
+	frame_state[idx] = FRAME_FREE | order;
+	frame_prev[idx] = LIST_END;
+	frame_next[idx] = free_lists[order];
+	if (free_lists[order] != LIST_END)
+		frame_prev[free_lists[order]] = idx;
+	free_lists[order] = idx;
+}
+
+/*
+ * list_remove
+ * DESCRIPTION: unlinks a free block from its order's free list
+ * INPUTS: order: block order, idx: first frame of the block
+ * SIDE EFFECTS: marks the block allocated
+ * RETURN VALUE: none
+ */
+static void list_remove(uint32_t order, uint32_t idx) {
+	if (frame_prev[idx] != LIST_END)
+		frame_next[frame_prev[idx]] = frame_next[idx];
+	else
+		free_lists[order] = frame_next[idx];
+	if (frame_next[idx] != LIST_END)
+		frame_prev[frame_next[idx]] = frame_prev[idx];
+	frame_state[idx] = 0;
+}
+
+/*
+ * frame_add_region
+ * DESCRIPTION: hands the whole frames of an available RAM range to the allocator,
+ * freeing them one at a time lets the buddies merge into the largest blocks
+ * INPUTS: start, end: physical range, reserved_start, reserved_end: range to skip
+ * SIDE EFFECTS: grows the free lists
+ * RETURN VALUE: none
+ */
+static void frame_add_region(uint32_t start, uint32_t end, uint32_t reserved_start, uint32_t reserved_end) {
+	uint32_t addr;
+
+	start = (start + FRAME_SIZE - 1) & ~(FRAME_SIZE - 1);
+	end &= ~(FRAME_SIZE - 1);
+	if (start < FRAME_BASE)
+		start = FRAME_BASE;
+	if (end > FRAME_LIMIT)
+		end = FRAME_LIMIT;
+
+	for (addr = start; addr < end; addr += FRAME_SIZE) {
+		if (addr + FRAME_SIZE > reserved_start && addr < reserved_end)
+			continue;
+		frame_free(addr, 0);
+		if (addr + FRAME_SIZE > managed_top)
+			managed_top = addr + FRAME_SIZE;
+	}
+}
+
+/*
+ * frame_init
+ * DESCRIPTION: builds the free lists from the available regions of the multiboot
+ * memory map (or mem_upper when there is no map). Only RAM between FRAME_BASE
+ * and FRAME_LIMIT is managed
+ * INPUTS: mbi: multiboot information, reserved_start, reserved_end: physical range
+ * that must never be handed out (the filesystem module)
+ * SIDE EFFECTS: resets the allocator
+ * RETURN VALUE: none
+ */
+void frame_init(multiboot_info_t* mbi, uint32_t reserved_start, uint32_t reserved_end) {
+	memory_map_t* mmap;
+	uint32_t start, end;
+	int i;
+
+	for (i = 0; i <= MAX_FRAME_ORDER; i++)
+		free_lists[i] = LIST_END;
+	memset(frame_state, 0, sizeof(frame_state));
+	free_frames = 0;
+	managed_top = FRAME_BASE;
+
+	if (mbi->flags & MBI_MMAP_VALID) {
+		for (mmap = (memory_map_t *)mbi->mmap_addr;
+			(unsigned long)mmap < mbi->mmap_addr + mbi->mmap_length;
+			mmap = (memory_map_t *)((unsigned long)mmap + mmap->size + sizeof (mmap->size))) {
+			// nothing above 4 GB can be reached without PAE
+			if (mmap->type != MMAP_AVAILABLE || mmap->base_addr_high)
+				continue;
+			start = mmap->base_addr_low;
+			end = start + mmap->length_low;
+			if (mmap->length_high || end < start)
+				end = 0xFFFFFFFF;
+			frame_add_region(start, end, reserved_start, reserved_end);
+		}
+	} else if (mbi->flags & MBI_MEM_VALID) {
+		// mem_upper is the KB of RAM starting at 1 MB
+		frame_add_region(LOW_MEM_END, LOW_MEM_END + (mbi->mem_upper << 10), reserved_start, reserved_end);
+	}
+}
+
+/*
+ * frame_alloc
+ * DESCRIPTION: takes the smallest free block that fits, splitting larger blocks
+ * and returning their unused halves to the free lists
+ * INPUTS: order: block size is 2^order frames
+ * SIDE EFFECTS: shrinks the free lists
+ * RETURN VALUE: physical (and direct mapped) address of the block, NO_FRAME if none
+ */
+uint32_t frame_alloc(uint32_t order) {
+	uint32_t o, idx;
+
+	if (order > MAX_FRAME_ORDER)
+		return NO_FRAME;
+	for (o = order; o <= MAX_FRAME_ORDER; o++) {
+		if (free_lists[o] != LIST_END)
+			break;
+	}
+	if (o > MAX_FRAME_ORDER)
+		return NO_FRAME;
+
+	idx = free_lists[o];
+	list_remove(o, idx);
+	while (o > order) {
+		o--;
+		list_push(o, idx + (1 << o));
+	}
+	free_frames -= 1 << order;
+	return FRAME_BASE + (idx << FRAME_SHIFT);
+}
+
+/*
+ * frame_free
+ * DESCRIPTION: returns a block and merges it with its buddy for as long as the
+ * buddy is a free block of the same order
+ * INPUTS: addr: address from frame_alloc, order: order it was allocated with
+ * SIDE EFFECTS: grows the free lists
+ * RETURN VALUE: none
+ */
+void frame_free(uint32_t addr, uint32_t order) {
+	uint32_t idx, buddy;
+
+	if (addr < FRAME_BASE || addr >= FRAME_LIMIT || order > MAX_FRAME_ORDER)
+		return;
+	idx = (addr - FRAME_BASE) >> FRAME_SHIFT;
+	if ((idx & ((1 << order) - 1)) || (frame_state[idx] & FRAME_FREE))
+		return;
+
+	free_frames += 1 << order;
+	while (order < MAX_FRAME_ORDER) {
+		buddy = idx ^ (1 << order);
+		if (buddy >= FRAME_COUNT || frame_state[buddy] != (FRAME_FREE | order))
+			break;
+		list_remove(order, buddy);
+		idx &= ~(1 << order);
+		order++;
+	}
+	list_push(order, idx);
+}
+
+/*
+ * frame_free_count
+ * DESCRIPTION: reports how many 4 KB frames are free
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: free frame count
+ */
+uint32_t frame_free_count() {
+	return free_frames;
+}
+
+/*
+ * frame_top
+ * DESCRIPTION: reports the end of the highest managed frame, paging_init direct
+ * maps physical memory up to here so the kernel can reach every frame
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: physical address
+ */
+uint32_t frame_top() {
+	return managed_top;
+}
@@ -0,0 +1,31 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "types.h"
+#include "multiboot.h"
+
+#define FRAME_SIZE 0x1000
+#define FRAME_SHIFT 12
+#define MAX_FRAME_ORDER 10 // largest block is 2^10 frames, one 4 MB page
+#define FRAME_BASE 0x800000 // below this is low memory and the kernel page
+#define FRAME_LIMIT 0x8000000 // RAM is direct mapped up to the program window
+#define FRAME_COUNT ((FRAME_LIMIT - FRAME_BASE) >> FRAME_SHIFT)
+#define MMAP_AVAILABLE 1
+#define NO_FRAME 0
+
+// build the free lists from the multiboot memory map, skipping [reserved_start, reserved_end)
+void frame_init(multiboot_info_t* mbi, uint32_t reserved_start, uint32_t reserved_end);
+
+// allocate 2^order contiguous, naturally aligned frames, NO_FRAME if none are left
+uint32_t frame_alloc(uint32_t order);
+
+// return a block from frame_alloc with the same order
+void frame_free(uint32_t addr, uint32_t order);
+
+// number of free 4 KB frames
+uint32_t frame_free_count();
+
+// end of the highest managed frame, everything below is direct mapped
+uint32_t frame_top();
+
+#endif // FRAME_H
@@ -6,3 +6,13 @@
  * RETURN VALUE: never returns
  */
 void system_call(void);
+
+/*
+ * sysenter_entry
+ * DESCRIPTION: SYSENTER system call entry, same calls and registers as
+ * system_call plus the user return address in ESI and stack in EBP
+ * INPUTS: no inputs
+ * SIDE EFFECTS: runs the system call, leaves with SYSEXIT
+ * RETURN VALUE: system call's return value in EAX
+ */
+void sysenter_entry(void);
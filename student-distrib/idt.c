@@ -4,10 +4,15 @@
 #include "i8259.h"
 #include "idt.h"
 #include "syscalls.h"
+#include "paging.h"
 #include "drivers/pit.h"
+#include "timer.h"
 #include "drivers/keyboard.h"
 #include "drivers/rtc.h"
 
+// set once the SYSENTER MSRs point at sysenter_entry
+static int sysenter_on = 0;
+
 // Exception handlers
 
 /*
@@ -220,6 +225,21 @@ void handler_page_fault() {
 	sys_halt (EXCEPTION_ERROR);
 }
 
+/*
+ * do_page_fault
+ * DESCRIPTION: Fills not present pages of the user program window on first touch,
+ * anything else is a real page fault exception
+ * INPUTS: fault_addr: linear address from cr2, error_code: error code pushed by the cpu
+ * SIDE EFFECTS: maps a user page or halts the process
+ * RETURN VALUE: none (returns only when the page was mapped)
+ */
+void do_page_fault(uint32_t fault_addr, uint32_t error_code) {
+	if (!(error_code & FAULT_PRESENT) && page_in(fault_addr) == 0) {
+		return;
+	}
+	handler_page_fault();
+}
+
 /*
  * handler_assertion_failure
  * DESCRIPTION: Generic default assertion failure
@@ -336,8 +356,8 @@ void idt_init() {
 	// based on https://courses.engr.illinois.edu/ece391/fa2022/secure/references/IA32-ref-manual-vol-3.pdf
 	// diagram 5-2 pg 156
 
-	// init drivers for rtc/keyboard
-	pit_init(35);
+	// init drivers for timer/rtc/keyboard
+	timer_init();
 	keyboard_init();
 	rtc_init();
 
@@ -370,7 +390,7 @@ void idt_init() {
 	SET_IDT_ENTRY(idt[11], handler_seg_np); // segment not present exception
 	SET_IDT_ENTRY(idt[12], handler_stk_fault); // stack fault exception
 	SET_IDT_ENTRY(idt[13], handler_gen_prot); // general protection fault exception
-	SET_IDT_ENTRY(idt[14], handler_page_fault); // page fault exception
+	SET_IDT_ENTRY(idt[14], page_fault_linkage); // page fault exception (demand paging)
 	SET_IDT_ENTRY(idt[15], handler_assertion_failure);
 	SET_IDT_ENTRY(idt[16], handler_fpu_error); // x87 FPU floating point error exception
 	SET_IDT_ENTRY(idt[17], handler_align_chk); // alignment check exception
@@ -385,4 +405,22 @@ void idt_init() {
 	// syscall
 	SET_IDT_ENTRY(idt[SYSCA], system_call);
 
+	// fast syscall, SYSEXIT derives the user selectors from KERNEL_CS (USER_CS = +16, USER_DS = +24)
+	if (cpuid_features() & CPUID_SEP) {
+		wrmsr(MSR_SYSENTER_CS, KERNEL_CS);
+		wrmsr(MSR_SYSENTER_ESP, tss.esp0);
+		wrmsr(MSR_SYSENTER_EIP, (uint32_t) sysenter_entry);
+		sysenter_on = 1;
+	}
+}
+
+/*
+ * sysenter_enabled
+ * DESCRIPTION: tells whether idt_init set up the SYSENTER MSRs
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 1 if the CPU has SEP, 0 if only int $0x80 works
+ */
+int sysenter_enabled() {
+	return sysenter_on;
 }
@@ -3,6 +3,10 @@
 
 #define IRQT_S 16
 #define SYSCA 0x80
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+#define CPUID_SEP 0x800 // SYSENTER/SYSEXIT
 // Previous Registers Struct
 typedef struct prev_reg {
 	uint32_t EDI, ESI, EBP, ESP, EBX, EDX, ECX, EAX, IRQ;
@@ -36,11 +40,18 @@ void handler_pit();
 void handler_keyboard();
 void handler_rtc();
 void handler_interrupt();
+void page_fault_linkage();
 
 // irq handler
 unsigned int do_IRQ(prev_reg_t regs);
 
+// page fault handler, demand pages user memory or kills the process
+void do_page_fault(uint32_t fault_addr, uint32_t error_code);
+
 // initialises IDT
 void idt_init();
 
+// 1 if system calls can come in through SYSENTER
+int sysenter_enabled();
+
 #endif
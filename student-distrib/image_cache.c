@@ -0,0 +1,249 @@
+#include "image_cache.h"
+#include "lib.h"
+#include "paging.h"
+#include "frame.h"
+#include "syscalls.h"
+#include "drivers/filesystem.h"
+
+// prepared executables, the filesystem is read only so entries never go stale
+static program_image_t image_cache[IMAGE_CACHE_SIZE];
+
+/*
+ * elf_load_segments
+ * DESCRIPTION: reads an executable's ELF header and program header table and keeps
+ * its PT_LOAD segments, which is all page_in needs to build the program image
+ * INPUTS: inode: executable inode, image: cache entry to fill
+ * SIDE EFFECTS: fills entry, seg_count and segments of image
+ * RETURN VALUE: 0 on success, -1 if not an ELF that fits the program window
+ */
+static int32_t elf_load_segments(uint32_t inode, program_image_t* image) {
+	// Magic string at start of ELF file
+	char magic_string[ELF_MAGIC_LEN] = { 0x7F, 'E', 'L', 'F' };
+	uint32_t window_end = BASE_VIRT_ADDR + FOUR_MIB;
+	uint32_t file_size = read_inode_size(inode);
+	load_segment_t* seg;
+	elf_header_t elf;
+	program_header_t ph;
+	uint32_t i;
+
+	if (read_data(inode, 0, &elf, sizeof(elf)) != sizeof(elf))
+		return -1;
+
+	// Verify executable string
+	if (strncmp((const int8_t*) elf.e_ident, magic_string, ELF_MAGIC_LEN)) {
+		printf("MAGIC STRING WRONG!!!!\n");
+		return -1;
+	}
+	if (elf.e_phentsize != sizeof(program_header_t))
+		return -1;
+
+	image->seg_count = 0;
+	for (i = 0; i < elf.e_phnum; i++) {
+		if (read_data(inode, elf.e_phoff + i * sizeof(ph), &ph, sizeof(ph)) != sizeof(ph))
+			return -1;
+		if (ph.p_type != PT_LOAD)
+			continue;
+
+		// segment has to sit inside the program window, and its file bytes inside the file
+		if (image->seg_count == MAX_SEGMENTS || ph.p_filesz > ph.p_memsz ||
+			ph.p_vaddr < BASE_VIRT_ADDR || ph.p_vaddr >= window_end || ph.p_memsz > window_end - ph.p_vaddr ||
+			ph.p_offset > file_size || ph.p_filesz > file_size - ph.p_offset)
+			return -1;
+
+		seg = &image->segments[image->seg_count++];
+		seg->vaddr = ph.p_vaddr;
+		seg->offset = ph.p_offset;
+		seg->filesz = ph.p_filesz;
+		seg->memsz = ph.p_memsz;
+		seg->flags = ph.p_flags;
+	}
+
+	if (image->seg_count == 0 || elf.e_entry < BASE_VIRT_ADDR || elf.e_entry >= window_end)
+		return -1;
+	image->entry = elf.e_entry;
+	return 0;
+}
+
+/*
+ * image_find_shared_pages
+ * DESCRIPTION: lists the pages of read only segments that no writable segment
+ * touches, their contents never change so every instance can map one copy
+ * INPUTS: image: parsed image
+ * SIDE EFFECTS: fills shared_count and shared of image
+ * RETURN VALUE: none
+ */
+static void image_find_shared_pages(program_image_t* image) {
+	uint32_t i, j, page, end;
+	load_segment_t* seg;
+	load_segment_t* other;
+
+	image->shared_count = 0;
+	for (i = 0; i < image->seg_count; i++) {
+		seg = &image->segments[i];
+		if (seg->flags & PF_W)
+			continue;
+		end = seg->vaddr + seg->memsz;
+		for (page = seg->vaddr & ~(PAGE_SIZE - 1); page < end; page += PAGE_SIZE) {
+			for (j = 0; j < image->seg_count; j++) {
+				other = &image->segments[j];
+				if ((other->flags & PF_W) && other->vaddr < page + PAGE_SIZE && page < other->vaddr + other->memsz)
+					break;
+			}
+			if (j != image->seg_count || image->shared_count == MAX_SHARED_PAGES)
+				continue;
+			image->shared[image->shared_count].vaddr = page;
+			image->shared[image->shared_count].frame = NO_FRAME;
+			image->shared_count++;
+		}
+	}
+}
+
+/*
+ * image_release_frames
+ * DESCRIPTION: returns an evicted image's shared pages to the frame allocator
+ * INPUTS: image: image with no running instances
+ * SIDE EFFECTS: frees shared frames
+ * RETURN VALUE: none
+ */
+static void image_release_frames(program_image_t* image) {
+	uint32_t i;
+	for (i = 0; i < image->shared_count; i++) {
+		if (image->shared[i].frame)
+			frame_free(image->shared[i].frame, 0);
+		image->shared[i].frame = NO_FRAME;
+	}
+}
+
+/*
+ * image_get
+ * DESCRIPTION: returns the prepared image of an executable, parsing its headers
+ * only the first time (or after it was evicted)
+ * INPUTS: inode: executable inode
+ * SIDE EFFECTS: takes a reference on the image, may evict an unused image
+ * RETURN VALUE: the image, or NULL if it is not a loadable executable
+ */
+program_image_t* image_get(uint32_t inode) {
+	program_image_t* image;
+	program_image_t* slot = NULL;
+	int i;
+
+	for (i = 0; i < IMAGE_CACHE_SIZE; i++) {
+		image = &image_cache[i];
+		if (image->valid && image->inode == inode) {
+			image->refs++;
+			return image;
+		}
+		// prefer an empty slot, otherwise reuse an image nobody is running
+		if (!image->valid && (!slot || slot->valid))
+			slot = image;
+		else if (image->valid && image->refs == 0 && !slot)
+			slot = image;
+	}
+
+	if (!slot)
+		return NULL;
+	if (slot->valid)
+		image_release_frames(slot);
+
+	slot->valid = 0;
+	if (elf_load_segments(inode, slot) == -1)
+		return NULL;
+	image_find_shared_pages(slot);
+	slot->inode = inode;
+	slot->refs = 1;
+	slot->valid = 1;
+	return slot;
+}
+
+/*
+ * image_put
+ * DESCRIPTION: drops a reference taken by image_get, the image stays cached
+ * INPUTS: image: image the exiting process was running (may be NULL)
+ * SIDE EFFECTS: decrements refs
+ * RETURN VALUE: none
+ */
+void image_put(program_image_t* image) {
+	if (image && image->refs)
+		image->refs--;
+}
+
+/*
+ * image_maps_page
+ * DESCRIPTION: checks a page of the program window belongs to the program's
+ * text, data or BSS
+ * INPUTS: image: program image, page_addr: page in the program window
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 1 if a segment overlaps the page, 0 otherwise
+ */
+int image_maps_page(program_image_t* image, uint32_t page_addr) {
+	uint32_t i;
+	load_segment_t* seg;
+
+	for (i = 0; i < image->seg_count; i++) {
+		seg = &image->segments[i];
+		if (seg->vaddr < page_addr + PAGE_SIZE && page_addr < seg->vaddr + seg->memsz)
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * image_fill_page
+ * DESCRIPTION: writes one page of the program image: the p_filesz bytes of every
+ * segment overlapping it, zero everywhere else (BSS, gaps, stack)
+ * INPUTS: image: program image (NULL gives a zero page), page_addr: page in the
+ * program window, dest: kernel accessible address to build the page at
+ * SIDE EFFECTS: writes PAGE_SIZE bytes at dest
+ * RETURN VALUE: none
+ */
+void image_fill_page(program_image_t* image, uint32_t page_addr, void* dest) {
+	uint32_t seg_count = image ? image->seg_count : 0;
+	uint32_t start, end, i;
+	load_segment_t* seg;
+
+	// skip the clear when one segment's file bytes cover the whole page
+	for (i = 0; i < seg_count; i++) {
+		seg = &image->segments[i];
+		if (seg->vaddr <= page_addr && page_addr + PAGE_SIZE <= seg->vaddr + seg->filesz)
+			break;
+	}
+	if (i == seg_count)
+		memset(dest, 0, PAGE_SIZE);
+
+	for (i = 0; i < seg_count; i++) {
+		seg = &image->segments[i];
+		start = seg->vaddr > page_addr ? seg->vaddr : page_addr;
+		end = seg->vaddr + seg->filesz < page_addr + PAGE_SIZE ? seg->vaddr + seg->filesz : page_addr + PAGE_SIZE;
+		if (start < end)
+			read_data(image->inode, seg->offset + (start - seg->vaddr), dest + (start - page_addr), end - start);
+	}
+}
+
+/*
+ * image_shared_frame
+ * DESCRIPTION: finds the shared copy of a read only program page, building it on
+ * first use so later instances just map it
+ * INPUTS: image: program image, page_addr: page in the program window
+ * SIDE EFFECTS: may take a frame from the frame allocator
+ * RETURN VALUE: physical address to map read only, or 0 if the page is private
+ */
+uint32_t image_shared_frame(program_image_t* image, uint32_t page_addr) {
+	uint32_t i, frame;
+
+	for (i = 0; i < image->shared_count; i++) {
+		if (image->shared[i].vaddr != page_addr)
+			continue;
+		if (image->shared[i].frame)
+			return image->shared[i].frame;
+
+		// out of memory, this instance gets a private copy instead
+		frame = frame_alloc(0);
+		if (frame == NO_FRAME)
+			return 0;
+		// frames are direct mapped, so the kernel builds the page through its physical address
+		image_fill_page(image, page_addr, (void*) frame);
+		image->shared[i].frame = frame;
+		return frame;
+	}
+	return 0;
+}
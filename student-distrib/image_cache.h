@@ -0,0 +1,53 @@
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include "types.h"
+
+#define IMAGE_CACHE_SIZE 16
+#define MAX_SEGMENTS 4
+#define MAX_SHARED_PAGES 16
+#define PF_W 0x2
+
+// PT_LOAD segment kept for page_in
+typedef struct load_segment {
+	uint32_t vaddr;  // where the segment starts in the program window
+	uint32_t offset; // where its bytes start in the executable
+	uint32_t filesz; // bytes backed by the file, the rest up to memsz is BSS
+	uint32_t memsz;
+	uint32_t flags;  // p_flags, read only segments can be shared
+} load_segment_t;
+
+// read only program page whose contents are identical in every instance
+typedef struct shared_page {
+	uint32_t vaddr; // page in the program window
+	uint32_t frame; // physical page holding it, 0 until first touched
+} shared_page_t;
+
+// parsed executable, ready to be mapped by page_in
+typedef struct program_image {
+	int32_t valid;
+	int32_t inode;
+	uint32_t refs; // processes currently running this image
+	uint32_t entry;
+	uint32_t seg_count;
+	load_segment_t segments[MAX_SEGMENTS];
+	uint32_t shared_count;
+	shared_page_t shared[MAX_SHARED_PAGES];
+} program_image_t;
+
+// get the prepared image for an executable inode, parsing it on a miss
+program_image_t* image_get(uint32_t inode);
+
+// drop a process' reference to its image
+void image_put(program_image_t* image);
+
+// physical page to map read only for page_addr, or 0 if it must be private
+uint32_t image_shared_frame(program_image_t* image, uint32_t page_addr);
+
+// whether any PT_LOAD segment covers part of page_addr
+int image_maps_page(program_image_t* image, uint32_t page_addr);
+
+// build the contents of one program page into dest
+void image_fill_page(program_image_t* image, uint32_t page_addr, void* dest);
+
+#endif // IMAGE_CACHE_H
@@ -10,6 +10,11 @@
 #include "idt.h"
 #include "paging.h"
 #include "pcb.h"
+#include "frame.h"
+#include "kmalloc.h"
+#include "scheduling.h"
+#include "clock.h"
+#include "vdso.h"
 #include "drivers/filesystem.h"
 #include "drivers/keyboard.h"
 #include "syscall_wrapper.h"
@@ -158,12 +163,28 @@ void entry(unsigned long magic, unsigned long addr) {
 	/* Initialize idt vectors */
 	idt_init();
 
+	/* Calibrate the TSC against the PIT, stamp the boot wall clock */
+	clock_init();
+	printf("TSC at %u kHz, booted at %u\n", clock_tsc_khz(), clock_boot_time());
+
 	/* Initialize filesystem */
 	filesystem_init(filesys_start, filesys_end);
 
+	/* Hand the RAM in the memory map (minus the filesystem) to the frame allocator */
+	frame_init(mbi, filesys_start, filesys_end);
+	printf("%u KB of frames free\n", frame_free_count() * (FRAME_SIZE >> 10));
+
 	/* Initializing paging */
 	paging_init();
 
+	/* Kernel heap and the PCB cache on top of it */
+	kmalloc_init();
+	pcb_init();
+
+	/* Page of clock and task info every process can read without a system call */
+	if (vdso_init() == -1)
+		printf("No memory for the vdso page\n");
+
 	/* Start Tertminal */
 	set_terminal_mode(1);
 
@@ -183,6 +204,9 @@ void entry(unsigned long magic, unsigned long addr) {
 	launch_tests();
 #endif
 
+	/* Hand the CPU to the base shells, the boot stack is not used again */
+	launch_base_shells();
+
 	/* Spin (nicely, so we don't chew up cycles) */
 	asm volatile (".1: hlt; jmp .1;");
 }
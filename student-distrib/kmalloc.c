@@ -0,0 +1,318 @@
+#include "kmalloc.h"
+#include "frame.h"
+#include "lib.h"
+
+#define SLOT_ALIGN 4
+#define FRAGMENT_SHIFT 3 // pick the smallest slab wasting at most 1/8 of itself
+#define PERCENT 100
+
+// header in front of an allocation too big for the kmalloc caches
+typedef struct large_block {
+	uint32_t magic;
+	uint32_t order;
+	uint32_t size;
+	uint32_t pad; // keeps the returned memory 16 byte aligned
+} large_block_t;
+
+// the cache that kmem_cache_create takes new cache descriptors from
+static kmem_cache_t cache_cache = {
+	.name = (const int8_t*) "kmem_cache",
+	.obj_size = sizeof(kmem_cache_t),
+	.slot_size = (sizeof(kmem_cache_t) + SLOT_ALIGN - 1) & ~(SLOT_ALIGN - 1),
+	.order = 0,
+	.per_slab = (FRAME_SIZE - sizeof(slab_t)) / ((sizeof(kmem_cache_t) + SLOT_ALIGN - 1) & ~(SLOT_ALIGN - 1)),
+};
+static kmem_cache_t* cache_list = &cache_cache;
+static kmem_cache_t* kmalloc_caches[KMALLOC_CACHES];
+static int8_t* kmalloc_names[KMALLOC_CACHES] = {
+	"kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+	"kmalloc-256", "kmalloc-512", "kmalloc-1024"
+};
+static uint32_t large_blocks = 0;
+static uint32_t large_bytes = 0;
+
+/*
+ * slab_bytes
+ * DESCRIPTION: size of one slab of a cache
+ * INPUTS: cache: cache
+ * SIDE EFFECTS: none
+ * RETURN VALUE: bytes per slab
+ */
+static uint32_t slab_bytes(kmem_cache_t* cache) {
+	return FRAME_SIZE << cache->order;
+}
+
+/*
+ * partial_push
+ * DESCRIPTION: links a slab at the head of its cache's partial list
+ * INPUTS: cache: owner, slab: slab with a free object
+ * SIDE EFFECTS: changes the partial list
+ * RETURN VALUE: none
+ */
+static void partial_push(kmem_cache_t* cache, slab_t* slab) {
+	slab->prev = NULL;
+	slab->next = cache->partial;
+	if (cache->partial)
+		cache->partial->prev = slab;
+	cache->partial = slab;
+}
+
+/*
+ * partial_remove
+ * DESCRIPTION: unlinks a slab from its cache's partial list
+ * INPUTS: cache: owner, slab: slab on the partial list
+ * SIDE EFFECTS: changes the partial list
+ * RETURN VALUE: none
+ */
+static void partial_remove(kmem_cache_t* cache, slab_t* slab) {
+	if (slab->prev)
+		slab->prev->next = slab->next;
+	else
+		cache->partial = slab->next;
+	if (slab->next)
+		slab->next->prev = slab->prev;
+	slab->next = NULL;
+	slab->prev = NULL;
+}
+
+/*
+ * slab_grow
+ * DESCRIPTION: takes a new slab for a cache from the frame allocator and threads
+ * all of its objects onto the slab's free list
+ * INPUTS: cache: cache with no partial slabs
+ * SIDE EFFECTS: allocates frames, puts the slab on the partial list
+ * RETURN VALUE: the new slab, NULL if out of memory
+ */
+static slab_t* slab_grow(kmem_cache_t* cache) {
+	slab_t* slab = (slab_t*) frame_alloc(cache->order);
+	uint8_t* obj;
+	uint32_t i;
+
+	if (slab == NULL)
+		return NULL;
+	slab->magic = SLAB_MAGIC;
+	slab->cache = cache;
+	slab->in_use = 0;
+	slab->free = NULL;
+	// objects start right after the header, last one ends up at the list head
+	obj = (uint8_t*) (slab + 1);
+	for (i = 0; i < cache->per_slab; i++, obj += cache->slot_size) {
+		*(void**) obj = slab->free;
+		slab->free = obj;
+	}
+	partial_push(cache, slab);
+	cache->slabs++;
+	return slab;
+}
+
+/*
+ * cache_create
+ * DESCRIPTION: sets up a cache for obj_size objects. The slab order is the
+ * smallest one that wastes no more than 1/8 of the slab, up to max_order
+ * INPUTS: name: shown in the stats, obj_size: bytes per object, max_order:
+ * largest slab order allowed
+ * SIDE EFFECTS: allocates the cache descriptor from cache_cache
+ * RETURN VALUE: the cache, NULL if out of memory or obj_size is too big
+ */
+static kmem_cache_t* cache_create(const int8_t* name, uint32_t obj_size, uint32_t max_order) {
+	kmem_cache_t* cache;
+	uint32_t slot_size = (obj_size + SLOT_ALIGN - 1) & ~(SLOT_ALIGN - 1);
+	uint32_t order, usable;
+
+	// a free object has to hold the free list pointer
+	if (slot_size < sizeof(void*))
+		slot_size = sizeof(void*);
+	for (order = 0; order <= max_order; order++) {
+		usable = (FRAME_SIZE << order) - sizeof(slab_t);
+		if (slot_size <= usable && (usable % slot_size + sizeof(slab_t)) <= ((FRAME_SIZE << order) >> FRAGMENT_SHIFT))
+			break;
+	}
+	if (order > max_order) {
+		order = max_order;
+		if (slot_size > (FRAME_SIZE << order) - sizeof(slab_t))
+			return NULL;
+	}
+
+	cache = kmem_cache_alloc(&cache_cache);
+	if (cache == NULL)
+		return NULL;
+	memset(cache, 0, sizeof(kmem_cache_t));
+	cache->name = name;
+	cache->obj_size = obj_size;
+	cache->slot_size = slot_size;
+	cache->order = order;
+	cache->per_slab = ((FRAME_SIZE << order) - sizeof(slab_t)) / slot_size;
+	cache->next = cache_list;
+	cache_list = cache;
+	return cache;
+}
+
+/*
+ * kmem_cache_create
+ * DESCRIPTION: sets up a cache for obj_size objects, with slabs of up to
+ * 2^MAX_SLAB_ORDER frames
+ * INPUTS: name: shown in the stats, obj_size: bytes per object
+ * SIDE EFFECTS: allocates the cache descriptor from cache_cache
+ * RETURN VALUE: the cache, NULL if out of memory or obj_size is too big
+ */
+kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t obj_size) {
+	return cache_create(name, obj_size, MAX_SLAB_ORDER);
+}
+
+/*
+ * kmem_cache_alloc
+ * DESCRIPTION: takes an object from the first partial slab, growing the cache
+ * when every slab is full
+ * INPUTS: cache: cache to allocate from
+ * SIDE EFFECTS: may allocate frames
+ * RETURN VALUE: the object (contents undefined), NULL if out of memory
+ */
+void* kmem_cache_alloc(kmem_cache_t* cache) {
+	slab_t* slab = cache->partial;
+	void* obj;
+
+	if (slab == NULL && (slab = slab_grow(cache)) == NULL)
+		return NULL;
+	obj = slab->free;
+	slab->free = *(void**) obj;
+	slab->in_use++;
+	if (slab->free == NULL)
+		partial_remove(cache, slab);
+	cache->in_use++;
+	cache->allocs++;
+	return obj;
+}
+
+/*
+ * kmem_cache_free
+ * DESCRIPTION: returns an object to its slab. Slabs are aligned to their size,
+ * so the slab header is found by masking the object address. An empty slab is
+ * given back to the frame allocator unless it is the cache's last one
+ * INPUTS: cache: cache the object came from, obj: object (NULL is ignored)
+ * SIDE EFFECTS: may free frames
+ * RETURN VALUE: none
+ */
+void kmem_cache_free(kmem_cache_t* cache, void* obj) {
+	slab_t* slab;
+
+	if (obj == NULL)
+		return;
+	slab = (slab_t*) ((uint32_t) obj & ~(slab_bytes(cache) - 1));
+	if (slab->magic != SLAB_MAGIC || slab->cache != cache)
+		return;
+
+	if (slab->free == NULL)
+		partial_push(cache, slab);
+	*(void**) obj = slab->free;
+	slab->free = obj;
+	slab->in_use--;
+	cache->in_use--;
+	cache->frees++;
+
+	if (slab->in_use == 0 && cache->slabs > 1) {
+		partial_remove(cache, slab);
+		slab->magic = 0;
+		frame_free((uint32_t) slab, cache->order);
+		cache->slabs--;
+	}
+}
+
+/*
+ * kmalloc_init
+ * DESCRIPTION: creates the power of two caches kmalloc serves small requests from.
+ * Their slabs are single frames, which is how kfree finds the slab header
+ * INPUTS: none
+ * SIDE EFFECTS: allocates cache descriptors
+ * RETURN VALUE: none
+ */
+void kmalloc_init() {
+	uint32_t i;
+	for (i = 0; i < KMALLOC_CACHES; i++)
+		kmalloc_caches[i] = cache_create(kmalloc_names[i], KMALLOC_MIN_SIZE << i, 0);
+}
+
+/*
+ * kmalloc
+ * DESCRIPTION: allocates from the smallest kmalloc cache that fits, anything
+ * bigger than KMALLOC_MAX_SIZE gets its own block of frames
+ * INPUTS: size: bytes needed
+ * SIDE EFFECTS: may allocate frames
+ * RETURN VALUE: the memory (contents undefined), NULL if out of memory
+ */
+void* kmalloc(uint32_t size) {
+	large_block_t* block;
+	uint32_t i, order;
+
+	if (size == 0)
+		return NULL;
+	if (size <= KMALLOC_MAX_SIZE) {
+		for (i = 0; (KMALLOC_MIN_SIZE << i) < size; i++)
+			;
+		return kmalloc_caches[i] ? kmem_cache_alloc(kmalloc_caches[i]) : NULL;
+	}
+
+	for (order = 0; order <= MAX_FRAME_ORDER; order++) {
+		if (size + sizeof(large_block_t) <= (FRAME_SIZE << order))
+			break;
+	}
+	block = (large_block_t*) frame_alloc(order);
+	if (block == NULL)
+		return NULL;
+	block->magic = LARGE_MAGIC;
+	block->order = order;
+	block->size = size;
+	large_blocks++;
+	large_bytes += size;
+	return block + 1;
+}
+
+/*
+ * kfree
+ * DESCRIPTION: frees memory from kmalloc. Cache objects live in single frame
+ * slabs and large blocks start with their header, so the frame the pointer is
+ * in tells which one it is
+ * INPUTS: ptr: memory from kmalloc (NULL is ignored)
+ * SIDE EFFECTS: may free frames
+ * RETURN VALUE: none
+ */
+void kfree(void* ptr) {
+	slab_t* slab;
+	large_block_t* block;
+
+	if (ptr == NULL)
+		return;
+	slab = (slab_t*) ((uint32_t) ptr & ~(FRAME_SIZE - 1));
+	if (slab->magic == SLAB_MAGIC) {
+		kmem_cache_free(slab->cache, ptr);
+		return;
+	}
+	block = (large_block_t*) slab;
+	if (block->magic == LARGE_MAGIC && (void*) (block + 1) == ptr) {
+		block->magic = 0;
+		large_blocks--;
+		large_bytes -= block->size;
+		frame_free((uint32_t) block, block->order);
+	}
+}
+
+/*
+ * kmem_print_stats
+ * DESCRIPTION: prints, per cache, objects in use out of the slots its slabs hold,
+ * and how much of the slab memory is not holding live objects (fragmentation)
+ * INPUTS: none
+ * SIDE EFFECTS: prints to the screen
+ * RETURN VALUE: none
+ */
+void kmem_print_stats() {
+	kmem_cache_t* cache;
+	uint32_t held, used;
+
+	printf("CACHE  OBJS/SLOTS  SLABS  KB  FRAG%%\n");
+	for (cache = cache_list; cache; cache = cache->next) {
+		held = cache->slabs * slab_bytes(cache);
+		used = cache->in_use * cache->obj_size;
+		printf("%s  %u/%u  %u  %u  %u\n", cache->name, cache->in_use, cache->slabs * cache->per_slab,
+			cache->slabs, held >> 10, held ? PERCENT - used * PERCENT / held : 0);
+	}
+	printf("large  %u blocks  %u bytes\n", large_blocks, large_bytes);
+}
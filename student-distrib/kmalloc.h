@@ -0,0 +1,61 @@
+#ifndef KMALLOC_H
+#define KMALLOC_H
+
+#include "types.h"
+
+#define KMALLOC_MIN_SIZE 16
+#define KMALLOC_MAX_SIZE 1024 // bigger requests get whole frames
+#define KMALLOC_CACHES 7 // 16, 32, ... 1024
+#define MAX_SLAB_ORDER 4 // slabs are at most 16 frames
+#define SLAB_MAGIC 0x51AB51AB
+#define LARGE_MAGIC 0x1A12E000
+
+struct kmem_cache;
+
+// header at the start of every slab, slabs are aligned to their size
+typedef struct slab {
+	uint32_t magic;
+	struct kmem_cache* cache;
+	struct slab* next; // partial list links
+	struct slab* prev;
+	void* free;        // free objects, each holds a pointer to the next
+	uint32_t in_use;
+} slab_t;
+
+// pool of same sized objects, carved out of slabs from the frame allocator
+typedef struct kmem_cache {
+	const int8_t* name;
+	uint32_t obj_size;  // size asked for
+	uint32_t slot_size; // obj_size rounded up to 4 bytes
+	uint32_t order;     // slab is 2^order frames
+	uint32_t per_slab;
+	slab_t* partial;    // slabs with at least one free object
+	uint32_t slabs;
+	uint32_t in_use;
+	uint32_t allocs;
+	uint32_t frees;
+	struct kmem_cache* next; // every cache, for the stats report
+} kmem_cache_t;
+
+// create the general purpose caches behind kmalloc, call after paging_init
+void kmalloc_init();
+
+// create a cache of obj_size objects, NULL if out of memory
+kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t obj_size);
+
+// take an object from a cache, NULL if out of memory
+void* kmem_cache_alloc(kmem_cache_t* cache);
+
+// give an object back to the cache it came from
+void kmem_cache_free(kmem_cache_t* cache, void* obj);
+
+// allocate size bytes of kernel memory, NULL if out of memory
+void* kmalloc(uint32_t size);
+
+// free memory from kmalloc, NULL is ignored
+void kfree(void* ptr);
+
+// print usage and fragmentation of every cache
+void kmem_print_stats();
+
+#endif // KMALLOC_H
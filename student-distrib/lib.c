@@ -292,11 +292,11 @@ void putc(uint8_t c) {
     update_cursor(screen_x, screen_y);
 }
 
-/* void putc_colourised(uint8_t c, uint8_t forecolour);
+/* static void emit_colourised(uint8_t c, uint8_t forecolour);
  * Inputs: uint_8* c = character to print, uint8_t forecolour = text colour in text mode 0
  * Return Value: void
- *  Function: Output a character to the console in the given forecolour */
-void putc_colourised(uint8_t c, uint8_t forecolour) {
+ *  Function: Puts a character on the screen and scrolls, leaving the cursor alone */
+static void emit_colourised(uint8_t c, uint8_t forecolour) {
 	uint8_t i;
 	if(c == '\n' || c == '\r') {
 		screen_y++;
@@ -332,12 +332,41 @@ void putc_colourised(uint8_t c, uint8_t forecolour) {
 		}
 		screen_y--;
 	}
+}
+
+/* void putc_colourised(uint8_t c, uint8_t forecolour);
+ * Inputs: uint_8* c = character to print, uint8_t forecolour = text colour in text mode 0
+ * Return Value: void
+ *  Function: Output a character to the console in the given forecolour */
+void putc_colourised(uint8_t c, uint8_t forecolour) {
+	emit_colourised(c, forecolour);
 	if (term_num != running_proc && !kb_flag){
 		return;
 	}
 	update_cursor(screen_x, screen_y);
 }
 
+/* int32_t putbuf_colourised(const uint8_t* buf, int32_t nbytes, uint8_t forecolour);
+ * Inputs: buf = characters to print, nbytes = how many, forecolour = text colour in text mode 0
+ * Return Value: characters printed, NULs are skipped
+ *  Function: Output a buffer to the console, moving the cursor once at the end
+ *            instead of once per character (four port writes each time) */
+int32_t putbuf_colourised(const uint8_t* buf, int32_t nbytes, uint8_t forecolour) {
+	int32_t i;
+	int32_t printed = 0;
+	for (i = 0; i < nbytes; i++) {
+		if (buf[i] != '\0') {
+			emit_colourised(buf[i], forecolour);
+			printed++;
+		}
+	}
+	if (printed == 0 || (term_num != running_proc && !kb_flag)){
+		return printed;
+	}
+	update_cursor(screen_x, screen_y);
+	return printed;
+}
+
 /* void removec();
  * Inputs: uint_8* c = character to print
  * Return Value: void
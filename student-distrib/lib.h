@@ -12,6 +12,7 @@
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
 void putc_colourised(uint8_t c, uint8_t forecolour);
+int32_t putbuf_colourised(const uint8_t* buf, int32_t nbytes, uint8_t forecolour);
 void removec();
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
@@ -40,6 +41,56 @@ void switch_term(int dest, int src);
 int32_t bad_userspace_addr(const void* addr, int32_t len);
 int32_t safe_strncpy(int8_t* dest, const int8_t* src, int32_t n);
 
+/* Reads the time stamp counter (cycles since reset). 64 bit division needs
+ * libgcc, which the kernel does not link, divide the results with div64_32 */
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile ("rdtsc"
+            : "=a"(lo), "=d"(hi)
+    );
+    return ((uint64_t) hi << 32) | lo;
+}
+
+/* Divides *n by d in place with two divl, returns the remainder */
+static inline uint32_t div64_32(uint64_t* n, uint32_t d) {
+    uint32_t hi = (uint32_t) (*n >> 32), lo = (uint32_t) *n, rem;
+    uint32_t q_hi = hi / d;
+
+    asm ("divl %4"
+            : "=a"(lo), "=d"(rem)
+            : "a"(lo), "d"(hi % d), "rm"(d)
+    );
+    *n = ((uint64_t) q_hi << 32) | lo;
+    return rem;
+}
+
+/* Writes a model specific register */
+static inline void wrmsr(uint32_t msr, uint64_t val) {
+    asm volatile ("wrmsr"
+            :
+            : "c"(msr), "a"((uint32_t) val), "d"((uint32_t) (val >> 32))
+    );
+}
+
+/* Reads a model specific register */
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    asm volatile ("rdmsr"
+            : "=a"(lo), "=d"(hi)
+            : "c"(msr)
+    );
+    return ((uint64_t) hi << 32) | lo;
+}
+
+/* Feature bits CPUID leaf 1 reports in EDX */
+static inline uint32_t cpuid_features(void) {
+    uint32_t eax = 1, ebx, ecx, edx;
+    asm volatile ("cpuid"
+            : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+    );
+    return edx;
+}
+
 /* Port read functions */
 /* Inb reads a byte and returns its value as a zero-extended 32-bit
  * unsigned int */
@@ -1,10 +1,22 @@
 #include "x86_desc.h"
 #include "paging.h"
 #include "lib.h"
+#include "pcb.h"
+#include "syscalls.h"
+#include "frame.h"
+#include "tlb.h"
+#include "drivers/filesystem.h"
 
 // keep track of next process page directory to be allocated
 static int process_in_use[MAX_PROCESSES] = {0};
-static void* process_pds[MAX_PROCESSES] = {pd_p0,pd_p1,pd_p2,pd_p3,pd_p4,pd_p5};
+// page directory and program window page table of each process
+static uint32_t* process_pds[MAX_PROCESSES];
+static uint32_t* process_pts[MAX_PROCESSES];
+// program pages mapped per process: private frames it owns, and image cache pages
+static uint32_t process_private[MAX_PROCESSES];
+static uint32_t process_shared[MAX_PROCESSES];
+// process whose page directory is currently in cr3
+static int paging_pid = KERNEL_PD;
 /*
  * paging_init
  * DESCRIPTION: Initialize the paging
@@ -13,12 +25,13 @@ static void* process_pds[MAX_PROCESSES] = {pd_p0,pd_p1,pd_p2,pd_p3,pd_p4,pd_p5};
  * RETURN VALUE: none
  */
 void paging_init(){
+    uint32_t i;
     /*
      * Fill in PDE for 0-4MB Page table
      * For this paging Entry:
      * 11-9 Avail, 8 G, 7 BIG_PAGE, 6 '0', 5 Accessed, 4 Cache Disabled, 3 PWT, 2 U/S, 1 R/W, 0 P
-     *     000      1     0            0          0              0          0      0       1    1
-     * which is 0x103 for last 12 bits
+     *     000      0     0            0          0              0          0      0       1    1
+     * which is 0x003 for last 12 bits (G is ignored here, the PTEs carry it)
      * First 24 bits is page table address
     */
     page_directory[0] = ((uint32_t) page_table) | WRITE_ENABLE | PRESENT;
@@ -33,6 +46,14 @@ void paging_init(){
     */
     page_directory[KERNAL_PAGE_ADDR] = (KERNAL_PAGE_ADDR << PD_ADDR_OFFSET) | GLOBAL | BIG_PAGE | WRITE_ENABLE | PRESENT;
 
+    /*
+     * Direct map the frame allocator's RAM (8 MB up to the program window) with
+     * supervisor 4 MB pages, so physical frame addresses are also kernel pointers
+     */
+    for (i = KERNAL_PAGE_ADDR_END; i < (frame_top() + BIG_PAGE_MASK) >> PD_ADDR_OFFSET; i++){
+        page_directory[i] = (i << PD_ADDR_OFFSET) | GLOBAL | BIG_PAGE | WRITE_ENABLE | PRESENT;
+    }
+
     /*
      * Fill in entry for address 0xB8, which is the page index for video mem
      * For this paging entry
@@ -41,7 +62,7 @@ void paging_init(){
      * which is 0x103 for the last 12 bits
      * B8 for next eight bits to represent VGA 4KB aligned address
      */
-    page_table[VIDMEM_ADDR] = (VIDMEM_ADDR << 12) | WRITE_ENABLE | PRESENT;
+    page_table[VIDMEM_ADDR] = (VIDMEM_ADDR << 12) | GLOBAL | WRITE_ENABLE | PRESENT;
 
     // setup terminal buff pages as well
     page_table[TERMINAL_0_VIDPAGE] = (TERMINAL_0_VIDPAGE << 12) | GLOBAL | WRITE_ENABLE | PRESENT;
@@ -56,13 +77,18 @@ void paging_init(){
 
     /* Enable paging for large page */
     asm volatile("mov %%cr4, %0": "=r"(cr4));
-    cr4 |= 0x10;
+    cr4 |= CR4_PSE;
     asm volatile("mov %0, %%cr4":: "r"(cr4));
 
-    /* Enable Paging */
+    /* Enable Paging, WP keeps the kernel from writing shared read only program pages */
     asm volatile("mov %%cr0, %0": "=r"(cr0));
-    cr0 |= 0x80000000;
+    cr0 |= 0x80010000;
     asm volatile("mov %0, %%cr0":: "r"(cr0));
+
+    /* Global pages survive cr3 writes, so context switches keep the kernel's TLB entries */
+    asm volatile("mov %%cr4, %0": "=r"(cr4));
+    cr4 |= CR4_PGE;
+    asm volatile("mov %0, %%cr4":: "r"(cr4));
 }
 
 /*
@@ -114,13 +140,14 @@ uint32_t virtual_to_physical(uint32_t virtual_addr){
  * alloc_new_process
  * DESCRIPTION: allocates a new page and sets up a PD
  * INPUTS: None
- * SIDE EFFECTS: Finds an open PD and sets it up
- * RETURN VALUE: the PID or -1 if no open PDs
+ * SIDE EFFECTS: Takes a PD and PT from the frame allocator, program pages come later (page_in)
+ * RETURN VALUE: the PID or -1 if no PID or not enough memory
  */
 int alloc_new_process(){
     int open_process, i;
-    int* cur_pd;
-    // find an open PD to use
+    uint32_t* cur_pd;
+    uint32_t* cur_pt;
+    // find an open PID to use
     for (open_process = 0; open_process < MAX_PROCESSES; open_process++){
         if (process_in_use[open_process] == 0){
             break;
@@ -130,48 +157,71 @@ int alloc_new_process(){
     if(open_process == MAX_PROCESSES){
         return -1;
     }
+    if (alloc_task_stack(open_process) == -1){
+        return -1;
+    }
+    cur_pd = (uint32_t*)frame_alloc(0);
+    cur_pt = (uint32_t*)frame_alloc(0);
+    if (cur_pd == NULL || cur_pt == NULL){
+        frame_free((uint32_t)cur_pd, 0);
+        frame_free((uint32_t)cur_pt, 0);
+        return -1;
+    }
     // mark process as in use
     process_in_use[open_process] = 1;
-    cur_pd = (int*)process_pds[open_process];
+    process_pds[open_process] = cur_pd;
+    process_pts[open_process] = cur_pt;
+    process_private[open_process] = 0;
+    process_shared[open_process] = 0;
     // the page directory is set up as specified in Appendix C
     // Copy kernel page into current directory
     for(i = 0; i < TABLE_SIZE; i++){
       cur_pd[i] = page_directory[i];
     }
-    // 128 MB location program, set up big page (kernal page + PID)
-    cur_pd[USER_ADDR] = (((KERNAL_PAGE_ADDR_END)+open_process) << PD_ADDR_OFFSET) | BIG_PAGE | USER_SPACE | WRITE_ENABLE | PRESENT;
+    // every program page starts not present, page_in fills them on first touch
+    for(i = 0; i < TABLE_SIZE; i++){
+      cur_pt[i] = 0;
+    }
+    // 128 MB location program, backed by 4 KB frames as they are touched
+    cur_pd[USER_ADDR] = ((uint32_t) cur_pt) | USER_SPACE | WRITE_ENABLE | PRESENT;
     return open_process;
 }
 
 /*
  * dealloc_process
- * DESCRIPTION: Removes a given processes page from the PD
+ * DESCRIPTION: Returns a given process' PD, PT and private program pages
  * CALL AFTER CONTEXT SWITCH TO PARENT
  * INPUTS:
  * int pid: the PID of the process you want to stop
- * SIDE EFFECTS: Resets a given PDE 0s.
+ * SIDE EFFECTS: Frees the process' frames, its task stack stays with the PID
  * RETURN VALUE: -1: virtual_addr is already empty/invalid param   0: on success
  */
  int dealloc_process(int pid){
      int i;
-     int* cur_pd;
+     uint32_t* cur_pt;
      // make sure current process is actually in use
-     if(process_in_use[pid] == 0){
+     if(pid < 0 || pid >= MAX_PROCESSES || process_in_use[pid] == 0){
          return -1;
      }
      // set inuse to 0
      process_in_use[pid] = 0;
-     // clear the PD for the given process
-     cur_pd = (int*)process_pds[pid];
+     // shared pages belong to the image cache, only private ones are freed
+     cur_pt = process_pts[pid];
      for(i = 0; i < TABLE_SIZE; i++){
-         cur_pd[i] = 0;
+         if ((cur_pt[i] & PRESENT) && !(cur_pt[i] & SHARED_PAGE)){
+             frame_free(cur_pt[i] & ~SMALL_PAGE_MASK, 0);
+         }
      }
+     frame_free((uint32_t)process_pds[pid], 0);
+     frame_free((uint32_t)cur_pt, 0);
+     process_private[pid] = 0;
+     process_shared[pid] = 0;
      return 0;
  }
 
  /*
   * context_switch_paging
-  * DESCRIPTION: Switches PD to a given pid (7 is kernal PD)
+  * DESCRIPTION: Switches PD to a given pid (KERNEL_PD is the kernal PD)
   * CALL BEFORE CONTEXT DEALLOC
   * INPUTS:
   * int pid: the PID of the process you want to point to
@@ -179,27 +229,56 @@ int alloc_new_process(){
   * RETURN VALUE: -1: process not occuring   0: on success
   */
  int context_switch_paging(int pid){
-     if(pid == 6){
-         asm volatile("movl %0, %%cr3":: "r"(page_directory));
+     if(pid == KERNEL_PD){
+         tlb_load_cr3(page_directory);
+         paging_pid = KERNEL_PD;
          return 0;
      }
-     if(process_in_use[pid] == 0){
+     if(pid < 0 || pid >= MAX_PROCESSES || process_in_use[pid] == 0){
          return -1;
      }
-     asm volatile("movl %0, %%cr3":: "r"((int*)process_pds[pid]));
+     tlb_load_cr3(process_pds[pid]);
+     paging_pid = pid;
      return 0;
  }
 
+ /*
+  * paging_set_pid
+  * DESCRIPTION: Records which process' page directory is loaded, for when
+  * switch_to loads CR3 itself
+  * INPUTS: int pid: process about to run
+  * SIDE EFFECTS: page_in maps pages for this process
+  * RETURN VALUE: none
+  */
+void paging_set_pid(int pid) {
+    paging_pid = pid;
+}
+
+ /*
+  * process_page_directory
+  * DESCRIPTION: Finds a process' page directory, the value CR3 holds while it runs
+  * INPUTS: int pid: process
+  * SIDE EFFECTS: none
+  * RETURN VALUE: the directory, NULL if the pid is not in use
+  */
+uint32_t* process_page_directory(int pid) {
+    if (pid < 0 || pid >= MAX_PROCESSES || process_in_use[pid] == 0){
+        return NULL;
+    }
+    return process_pds[pid];
+}
+
  /*
   * zero_base
-  * DESCRIPTION: Sets process_in_use[term] to 0
+  * DESCRIPTION: Frees the base shell of a terminal so it can be relaunched
   * CALL IN HALT FOR BASE SHELL
   * INPUTS: terminal number
-  * SIDE EFFECTS: none
+  * SIDE EFFECTS: loads the kernel PD, its own PD is about to be freed
   * RETURN VALUE: none
   */
 void zero_base(int term) {
-    process_in_use[term] = 0;
+    context_switch_paging(KERNEL_PD);
+    dealloc_process(term);
     return;
 }
 
@@ -207,35 +286,31 @@ void zero_base(int term) {
   * remap
   * DESCRIPTION: remaps paging so video mem not overwritten
   * INPUTS: terminal number
-  * SIDE EFFECTS: flushes TLB
+  * SIDE EFFECTS: invalidates the two video pages if their mapping changed
   * RETURN VALUE: none
   */
 void remap(int term) {
+    uint32_t term_page, vid_entry;
     switch (term) {
         case 0:
-            page_table[VIDMEM_ADDR] = page_table[TERMINAL_0_VIDPAGE];
-            page_table_vid[(VID_PAGE_START >> 12) & SMALL_MASK] = TERMINAL_0_VIDPAGE_FULL;
+            term_page = page_table[TERMINAL_0_VIDPAGE];
+            vid_entry = TERMINAL_0_VIDPAGE_FULL;
             break;
         case 1:
-            page_table[VIDMEM_ADDR] = page_table[TERMINAL_1_VIDPAGE];
-            page_table_vid[(VID_PAGE_START >> 12) & SMALL_MASK] = TERMINAL_1_VIDPAGE_FULL;
+            term_page = page_table[TERMINAL_1_VIDPAGE];
+            vid_entry = TERMINAL_1_VIDPAGE_FULL;
             break;
         case 2:
-            page_table[VIDMEM_ADDR] = page_table[TERMINAL_2_VIDPAGE];
-            page_table_vid[(VID_PAGE_START >> 12) & SMALL_MASK] = TERMINAL_2_VIDPAGE_FULL;
+            term_page = page_table[TERMINAL_2_VIDPAGE];
+            vid_entry = TERMINAL_2_VIDPAGE_FULL;
             break;
         default:
             return;
     }
 
-    // Flush TLBs
-    asm volatile (
-        "movl %%cr3, %%eax\n\t"
-        "movl %%eax, %%cr3\n\t"
-        :
-        :
-        : "eax"
-        );
+    // only the kernel's and vidmap's view of video memory change
+    tlb_set_entry(&page_table[VIDMEM_ADDR], term_page, VIDMEM_ADDR << PT_ADDR_OFFSET);
+    tlb_set_entry(&page_table_vid[(VID_PAGE_START >> PT_ADDR_OFFSET) & SMALL_MASK], vid_entry, VID_PAGE_START);
     return;
 }
 
@@ -243,21 +318,99 @@ void remap(int term) {
   * unmap
   * DESCRIPTION: unmaps proc video mem to write to screen buffer again
   * INPUTS: terminal number
-  * SIDE EFFECTS: flushes TLB
+  * SIDE EFFECTS: invalidates the two video pages if their mapping changed
   * RETURN VALUE: none
   */
 void unmap(int term) {
+    tlb_set_entry(&page_table[VIDMEM_ADDR], (VIDMEM_ADDR << PT_ADDR_OFFSET) | GLOBAL | WRITE_ENABLE | PRESENT, VIDMEM_ADDR << PT_ADDR_OFFSET);
+    tlb_set_entry(&page_table_vid[(VID_PAGE_START >> PT_ADDR_OFFSET) & SMALL_MASK], VIDMEM_PAGE_FULL, VID_PAGE_START);
+    return;
+}
 
-    page_table[VIDMEM_ADDR] = (VIDMEM_ADDR << 12) | WRITE_ENABLE | PRESENT;
-	page_table_vid[(VID_PAGE_START >> 12) & 0x3FF] = 0xB8107;
+ /*
+  * page_in
+  * DESCRIPTION: demand pages the current process' program window. Only pages
+  * under a PT_LOAD segment or in the stack area are mapped. Read only program
+  * pages are mapped from the image cache's shared copy; any other page gets a
+  * fresh frame, filled from the segments of the executable (zero everywhere else)
+  * INPUTS: virt_addr: faulting address (cr2)
+  * SIDE EFFECTS: sets a PTE in the current process page table, may write the page
+  * RETURN VALUE: 0 if the page was mapped, -1 if the address is not demand paged
+  */
+int page_in(uint32_t virt_addr) {
+    uint32_t page_addr = virt_addr & ~SMALL_PAGE_MASK;
+    uint32_t* cur_pt;
+    uint32_t frame;
+    program_image_t* image;
 
-    // Flush TLBs
-    asm volatile (
-        "movl %%cr3, %%eax\n\t"
-        "movl %%eax, %%cr3\n\t"
-        :
-        :
-        : "eax"
-        );
-    return;
+    // only the user program window is demand paged, and only for a live process
+    if (virt_addr < BASE_VIRT_ADDR || virt_addr >= BASE_VIRT_ADDR + FOUR_MIB || paging_pid == KERNEL_PD){
+        return -1;
+    }
+    cur_pt = process_pts[paging_pid];
+    if (cur_pt[(virt_addr >> PT_ADDR_OFFSET) & SMALL_MASK] & PRESENT){
+        return -1;
+    }
+
+    // anything outside text, data, BSS and the stack is a real fault
+    image = get_pcb(paging_pid)->image;
+    if (page_addr < USER_STACK_BOTTOM && !(image && image_maps_page(image, page_addr))){
+        return -1;
+    }
+
+    // text and rodata are identical in every instance, map the shared copy read only
+    if (image && (frame = image_shared_frame(image, page_addr))){
+        cur_pt[(virt_addr >> PT_ADDR_OFFSET) & SMALL_MASK] = frame | SHARED_PAGE | USER_SPACE | PRESENT;
+        process_shared[paging_pid]++;
+        return 0;
+    }
+
+    frame = frame_alloc(0);
+    if (frame == NO_FRAME){
+        return -1;
+    }
+    cur_pt[(virt_addr >> PT_ADDR_OFFSET) & SMALL_MASK] = frame | USER_SPACE | WRITE_ENABLE | PRESENT;
+    process_private[paging_pid]++;
+    image_fill_page(image, page_addr, (void*)frame);
+    return 0;
+}
+
+ /*
+  * process_resident_pages
+  * DESCRIPTION: reports how many program pages a process has mapped
+  * INPUTS: pid: process to look at, shared: filled with how many of those are
+  * image cache pages that other instances map too (may be NULL)
+  * SIDE EFFECTS: none
+  * RETURN VALUE: resident page count, -1 if the process does not exist
+  */
+int process_resident_pages(int pid, uint32_t* shared){
+    if (pid < 0 || pid >= MAX_PROCESSES || process_in_use[pid] == 0){
+        return -1;
+    }
+    if (shared){
+        *shared = process_shared[pid];
+    }
+    return process_private[pid] + process_shared[pid];
+}
+
+ /*
+  * print_resident_report
+  * DESCRIPTION: prints the resident program footprint of every process
+  * INPUTS: none
+  * SIDE EFFECTS: prints to the screen
+  * RETURN VALUE: none
+  */
+void print_resident_report(){
+    int i;
+    tlb_stats_t tlb;
+    printf("PID  KB  SHARED_KB  CMD\n");
+    for (i = 0; i < MAX_PROCESSES; i++){
+        if (process_in_use[i]){
+            printf("%d  %d  %d  %s\n", i, (process_private[i] + process_shared[i]) * (PAGE_SIZE >> 10),
+                process_shared[i] * (PAGE_SIZE >> 10), (int8_t*)get_pcb(i)->cmd);
+        }
+    }
+    printf("%d KB free\n", frame_free_count() * (PAGE_SIZE >> 10));
+    tlb_get_stats(&tlb);
+    printf("TLB: %u full, %u invlpg, %u skipped, %u cr3 loads\n", tlb.full_flushes, tlb.page_flushes, tlb.skipped, tlb.cr3_loads);
 }
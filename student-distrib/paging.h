@@ -1,7 +1,8 @@
 #ifndef PAGING_H
 #define PAGING_H
 
-#define MAX_PROCESSES 6
+#define MAX_PROCESSES 256 // PID slots, free memory is what limits processes
+#define KERNEL_PD -1
 #define PD_ADDR_OFFSET 22
 #define PT_ADDR_OFFSET 12
 #define VIRT_PT_OFFSET 10
@@ -16,15 +17,23 @@
 #define KERNAL_PAGE_ADDR_END 0x02
 #define USER_ADDR 32
 #define INVALID_ADDR 0xFFFFFFFF
-#define GLOBAL 0x80
+#define GLOBAL 0x100
+#define CR4_PSE 0x10
+#define CR4_PGE 0x80
 #define VIDMEM_ADDR 0xB8
 #define TERMINAL_0_VIDPAGE 0xB9
 #define TERMINAL_1_VIDPAGE 0xBA
 #define TERMINAL_2_VIDPAGE 0xBB
-#define TERMINAL_0_VIDPAGE_FULL 0xB9107
-#define TERMINAL_1_VIDPAGE_FULL 0xBA107
-#define TERMINAL_2_VIDPAGE_FULL 0xBB107
+// vidmap PTEs are user mappings, so never global
+#define TERMINAL_0_VIDPAGE_FULL 0xB9007
+#define TERMINAL_1_VIDPAGE_FULL 0xBA007
+#define TERMINAL_2_VIDPAGE_FULL 0xBB007
+#define VIDMEM_PAGE_FULL 0xB8007
 #define SMALL_MASK 0x3FF
+#define PAGE_SIZE 0x1000
+#define FAULT_PRESENT 0x1
+#define SHARED_PAGE 0x200 // available PTE bit, frame is owned by the image cache
+#define USER_STACK_BOTTOM 0x08300000 // top 1 MB of the program window is stack
 
 
 // Initialize paging
@@ -42,6 +51,12 @@ int dealloc_process(int pid);
 // switch between processes
 int context_switch_paging(int pid);
 
+// record pid's directory as the loaded one when switch_to loads it
+void paging_set_pid(int pid);
+
+// a process' page directory, NULL if the pid is not in use
+uint32_t* process_page_directory(int pid);
+
 // zeros out process_in_use[term] for base case
 void zero_base(int term);
 
@@ -51,4 +66,13 @@ void remap(int term);
 // switch mapping of vid mem back to actual vid mem
 void unmap();
 
+// map and fill the user page holding virt_addr on first touch
+int page_in(uint32_t virt_addr);
+
+// number of program pages a process has mapped
+int process_resident_pages(int pid, uint32_t* shared);
+
+// print every process' resident program footprint
+void print_resident_report();
+
 #endif // PAGING_H
@@ -1,12 +1,76 @@
 #include "pcb.h"
 #include "lib.h"
 #include "types.h"
+#include "paging.h"
+#include "kmalloc.h"
 
 // PCB is located at the TOP of current kernel stack
 // stack grows upside down
 // PCB is located at top of 8kb block
 
+// pid -> task stack, filled from task_stack_cache the first time the PID is used
+static task_stack_t* task_stacks[MAX_PROCESSES] = { NULL };
+static kmem_cache_t* task_stack_cache = NULL;
+
 pcb_t* get_pcb(int pid) {
-	// 8MB - 8KB times the pid number plus one since its at bottom
-	return ((pcb_t*) (K_PAGE_ADDR-((pid+1)*EIGHT_KB)));
+	return &(task_stacks[pid]->task_pcb);
+}
+
+/*
+ * pcb_init
+ * DESCRIPTION: creates the slab cache PCBs and kernel stacks come from
+ * INPUTS: none
+ * SIDE EFFECTS: allocates the cache descriptor
+ * RETURN VALUE: none
+ */
+void pcb_init() {
+	task_stack_cache = kmem_cache_create((const int8_t*) "task_stack", sizeof(task_stack_t));
+}
+
+/*
+ * get_task_stack
+ * DESCRIPTION: finds the 8 KB block holding a PID's PCB and kernel stack
+ * INPUTS: pid: PID with a task stack
+ * SIDE EFFECTS: none
+ * RETURN VALUE: the task stack, the stack top is one task_stack_t past it
+ */
+task_stack_t* get_task_stack(int pid) {
+	return task_stacks[pid];
+}
+
+/*
+ * alloc_task_stack
+ * DESCRIPTION: gives a PID its task stack. A base shell keeps its stack when it
+ * halts, since it relaunches on the stack it is running on
+ * INPUTS: pid: PID about to be used
+ * SIDE EFFECTS: may allocate from the task stack cache, zeroes a new PCB
+ * RETURN VALUE: 0 on success, -1 if out of memory
+ */
+int alloc_task_stack(int pid) {
+	task_stack_t* task_stack;
+
+	if (task_stacks[pid] != NULL)
+		return 0;
+	if (task_stack_cache == NULL)
+		return -1;
+	task_stack = kmem_cache_alloc(task_stack_cache);
+	if (task_stack == NULL)
+		return -1;
+	memset(&(task_stack->task_pcb), 0, sizeof(pcb_t));
+	task_stacks[pid] = task_stack;
+	return 0;
+}
+
+/*
+ * free_task_stack
+ * DESCRIPTION: returns an exited PID's task stack to the cache. Safe to call
+ * with interrupts off while still running on that stack: freeing only links
+ * the block into its slab's free list through the PCB's first word
+ * INPUTS: pid: exited PID
+ * SIDE EFFECTS: the PID's PCB is gone
+ * RETURN VALUE: none
+ */
+void free_task_stack(int pid) {
+	kmem_cache_free(task_stack_cache, task_stacks[pid]);
+	task_stacks[pid] = NULL;
 }
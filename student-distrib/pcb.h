@@ -3,33 +3,84 @@
 
 #include "drivers/filesystem.h"
 #include "fd.h"
+#include "image_cache.h"
 #include "types.h"
+#include "timer.h"
+#include "wait.h"
 
 // Each task can have up to 8 open files
 #define MAX_FILES 8
-#define K_PAGE_ADDR 0x800000
 #define EIGHT_KB 0x2000
 #define BUF_LEN 128
 
+// task states, only TASK_RUNNABLE tasks are on the run queue
+#define TASK_RUNNING 0  // on the CPU
+#define TASK_RUNNABLE 1 // waiting for the CPU
+#define TASK_WAITING 2  // parent blocked in execute until its child halts
+#define TASK_BLOCKED 3  // asleep on a wait queue
+#define TASK_ZOMBIE 4   // spawned task that halted, its parent frees it in wait, or the scheduler if the parent halted first
+
+// CPU time is in TSC cycles
+typedef struct task_stats {
+	uint64_t user_cycles;
+	uint64_t kernel_cycles;  // in system calls
+	uint64_t wait_cycles;    // runnable, waiting for the CPU
+	uint32_t voluntary;      // switches away because the task blocked
+	uint32_t involuntary;    // switches away because the task was preempted
+} task_stats_t;
+
 typedef struct pcb {
+	// switch.S reads these two at fixed offsets, keep them first
+	uint32_t ksp; // kernel stack pointer saved by switch_to
+	uint32_t cr3; // page directory, 0 to keep the current one
 	int pid;
 	int parent_id;
 	fd_t fd_array[MAX_FILES];
 	uint32_t par_esp;
 	uint32_t par_ebp;
-	uint32_t curr_esp;
-	uint32_t curr_ebp;
+	uint32_t curr_esp; // top of the kernel stack, esp0 while the task runs
 	uint8_t cmd[BUF_LEN];
 	uint8_t arg[BUF_LEN];
 	int active; // 1 if active/started
 	int vid_flag;
+	program_image_t* image; // cached executable backing the program window (page_in)
+	int state; // TASK_*
+	int term; // terminal the task runs in
+	struct pcb* run_next; // run queue or wait queue link, a task is on at most one
+	int priority; // MLFQ level, 0 is the highest
+	uint32_t boost_epoch; // last priority reset this task has seen
+	task_stats_t stats;
+	uint64_t stamp; // TSC when the running task's time was last charged
+	uint64_t queued_at; // TSC when it went on the run queue
+	int in_kernel; // 1 inside a system call, decides where its time goes
+	timer_entry_t sleep_timer; // wakes the task from sys_sleep
+	uint32_t trace_nr; // system call being traced, 0 if none
+	uint32_t trace_args[3];
+	uint64_t trace_start; // TSC at its entry
+	struct io_ring* ring; // registered submission ring (a user address), NULL if none
+	uint32_t ring_mask;
+	int spawned; // 1 if started by spawn, no parent sleeps in execute for it
+	int32_t exit_status; // halt status kept for wait
+	wait_queue_t child_wq; // this task sleeps here in wait until a spawned child halts
 } pcb_t;
 
-pcb_t* get_pcb(int pid);
-
 typedef struct task_stack {
 	pcb_t task_pcb;
 	int8_t kernel_stack[EIGHT_KB - sizeof(pcb_t)];
 } task_stack_t;
 
+pcb_t* get_pcb(int pid);
+
+// 8 KB block holding a PID's PCB and kernel stack
+task_stack_t* get_task_stack(int pid);
+
+// create the task stack cache
+void pcb_init();
+
+// give a PID its task stack on first use
+int alloc_task_stack(int pid);
+
+// return an exited PID's task stack to the cache
+void free_task_stack(int pid);
+
 #endif
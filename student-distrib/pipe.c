@@ -0,0 +1,199 @@
+#include "pipe.h"
+#include "lib.h"
+#include "pcb.h"
+#include "x86_desc.h"
+#include "kmalloc.h"
+
+/*
+ * pipe_of
+ * DESCRIPTION: Finds the pipe behind one of the current process' descriptors
+ * INPUTS: fd: descriptor open on a pipe end
+ * SIDE EFFECTS: none
+ * RETURN VALUE: the pipe
+ */
+static pipe_t* pipe_of(uint32_t fd) {
+	return get_pcb(pid)->fd_array[fd].pipe;
+}
+
+/*
+ * pipe_create
+ * DESCRIPTION: Allocates an empty pipe, the caller opens one descriptor on each end
+ * INPUTS: none
+ * SIDE EFFECTS: allocates kernel memory
+ * RETURN VALUE: the pipe, NULL if out of memory
+ */
+pipe_t* pipe_create() {
+	pipe_t* p = kmalloc(sizeof(pipe_t));
+
+	if (p == NULL)
+		return NULL;
+	memset(p, 0, sizeof(pipe_t));
+	p->readers = 1;
+	p->writers = 1;
+	return p;
+}
+
+/*
+ * pipe_dup
+ * DESCRIPTION: Counts one more descriptor on the end f is open on
+ * INPUTS: f: copy of a descriptor, pipe or not
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+void pipe_dup(fd_t* f) {
+	uint32_t flags;
+
+	if (f->pipe == NULL)
+		return;
+	cli_and_save(flags);
+	if (f->table_pointer.read == pipe_read)
+		f->pipe->readers++;
+	else
+		f->pipe->writers++;
+	restore_flags(flags);
+}
+
+/*
+ * pipe_read
+ * DESCRIPTION: Reads whatever is in the pipe, up to nbytes, sleeping while it
+ * is empty and some process can still write to it
+ * INPUTS: fd: read end, buf: where to put the data, nbytes: most to read
+ * SIDE EFFECTS: may block, wakes writers waiting for room
+ * RETURN VALUE: bytes read, 0 once the pipe is empty with no writers left, -1 for bad nbytes
+ */
+int32_t pipe_read(uint32_t fd, void* buf, int32_t nbytes) {
+	pipe_t* p = pipe_of(fd);
+	uint32_t flags, start, chunk;
+	int32_t done = 0;
+
+	if (nbytes <= 0)
+		return (nbytes == 0) ? 0 : -1;
+	cli_and_save(flags);
+	while (p->head == p->tail && p->writers > 0)
+		sleep_on(&p->read_wq);
+
+	// at most two pieces, before and after the wrap
+	while (done < nbytes && p->head != p->tail) {
+		start = p->head & (PIPE_SIZE - 1);
+		chunk = p->tail - p->head;
+		if (chunk > PIPE_SIZE - start)
+			chunk = PIPE_SIZE - start;
+		if (chunk > (uint32_t) (nbytes - done))
+			chunk = nbytes - done;
+		memcpy((uint8_t*) buf + done, p->buf + start, chunk);
+		p->head += chunk;
+		done += chunk;
+	}
+	wake_up(&p->write_wq);
+	restore_flags(flags);
+	return done;
+}
+
+/*
+ * pipe_write
+ * DESCRIPTION: Writes all of buf into the pipe, sleeping whenever it is full,
+ * unless every read end is closed
+ * INPUTS: fd: write end, buf: data, nbytes: its length
+ * SIDE EFFECTS: may block, wakes readers
+ * RETURN VALUE: bytes written, -1 if nothing could be written because no process reads the pipe
+ */
+int32_t pipe_write(uint32_t fd, const void* buf, int32_t nbytes) {
+	pipe_t* p = pipe_of(fd);
+	uint32_t flags, start, chunk;
+	int32_t done = 0;
+
+	if (nbytes < 0)
+		return -1;
+	cli_and_save(flags);
+	while (done < nbytes && p->readers > 0) {
+		if (p->tail - p->head == PIPE_SIZE) {
+			sleep_on(&p->write_wq);
+			continue;
+		}
+		start = p->tail & (PIPE_SIZE - 1);
+		chunk = PIPE_SIZE - (p->tail - p->head);
+		if (chunk > PIPE_SIZE - start)
+			chunk = PIPE_SIZE - start;
+		if (chunk > (uint32_t) (nbytes - done))
+			chunk = nbytes - done;
+		memcpy(p->buf + start, (const uint8_t*) buf + done, chunk);
+		p->tail += chunk;
+		done += chunk;
+		wake_up(&p->read_wq);
+	}
+	restore_flags(flags);
+	return (done == 0 && nbytes > 0) ? -1 : done;
+}
+
+/*
+ * pipe_bad_read
+ * DESCRIPTION: Reading the write end
+ * INPUTS: fd : file    buf: buffer to be filled    nbytes: number of bytes of buf
+ * SIDE EFFECTS: none
+ * RETURN VALUE: -1
+ */
+int32_t pipe_bad_read(uint32_t fd, void* buf, int32_t nbytes) {
+	return -1;
+}
+
+/*
+ * pipe_bad_write
+ * DESCRIPTION: Writing the read end
+ * INPUTS: fd : file    buf: buffer to be written    nbytes: number of bytes of buf
+ * SIDE EFFECTS: none
+ * RETURN VALUE: -1
+ */
+int32_t pipe_bad_write(uint32_t fd, const void* buf, int32_t nbytes) {
+	return -1;
+}
+
+/*
+ * pipe_release
+ * DESCRIPTION: Drops a descriptor's reference, frees the pipe with the last one
+ * INPUTS: fd: descriptor being closed
+ * SIDE EFFECTS: may free the pipe, call with interrupts off
+ * RETURN VALUE: none
+ */
+static void pipe_release(uint32_t fd) {
+	pipe_t* p = pipe_of(fd);
+
+	get_pcb(pid)->fd_array[fd].pipe = NULL;
+	if (p->readers == 0 && p->writers == 0)
+		kfree(p);
+}
+
+/*
+ * pipe_close_read
+ * DESCRIPTION: Closes a read end, with the last one gone writers get -1
+ * INPUTS: fd: read end
+ * SIDE EFFECTS: wakes writers
+ * RETURN VALUE: 0
+ */
+int32_t pipe_close_read(uint32_t fd) {
+	uint32_t flags;
+
+	cli_and_save(flags);
+	pipe_of(fd)->readers--;
+	wake_up(&(pipe_of(fd)->write_wq));
+	pipe_release(fd);
+	restore_flags(flags);
+	return 0;
+}
+
+/*
+ * pipe_close_write
+ * DESCRIPTION: Closes a write end, with the last one gone readers see end of file
+ * INPUTS: fd: write end
+ * SIDE EFFECTS: wakes readers
+ * RETURN VALUE: 0
+ */
+int32_t pipe_close_write(uint32_t fd) {
+	uint32_t flags;
+
+	cli_and_save(flags);
+	pipe_of(fd)->writers--;
+	wake_up(&(pipe_of(fd)->read_wq));
+	pipe_release(fd);
+	restore_flags(flags);
+	return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "types.h"
+#include "fd.h"
+#include "wait.h"
+
+#define PIPE_SIZE 2048 // power of two, the indices wrap with PIPE_SIZE - 1
+
+// one pipe, shared by every descriptor open on either end
+typedef struct pipe {
+	uint32_t head; // next byte to read, both indices only ever count up
+	uint32_t tail; // next byte to write
+	int32_t readers; // open read ends, across all processes
+	int32_t writers; // open write ends
+	wait_queue_t read_wq; // readers waiting for data or the last writer to go
+	wait_queue_t write_wq; // writers waiting for room or the last reader to go
+	uint8_t buf[PIPE_SIZE];
+} pipe_t;
+
+// a new pipe with one reader and one writer, NULL if out of memory
+pipe_t* pipe_create();
+
+// another descriptor now refers to the same end as f (spawn copies them)
+void pipe_dup(fd_t* f);
+
+// fd_ops_t handlers, the read end and the write end each get a table
+int32_t pipe_read(uint32_t fd, void* buf, int32_t nbytes);
+int32_t pipe_write(uint32_t fd, const void* buf, int32_t nbytes);
+int32_t pipe_bad_read(uint32_t fd, void* buf, int32_t nbytes);
+int32_t pipe_bad_write(uint32_t fd, const void* buf, int32_t nbytes);
+int32_t pipe_close_read(uint32_t fd);
+int32_t pipe_close_write(uint32_t fd);
+
+#endif // PIPE_H
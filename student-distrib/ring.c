@@ -0,0 +1,86 @@
+#include "ring.h"
+#include "lib.h"
+#include "pcb.h"
+#include "x86_desc.h"
+#include "syscalls.h"
+
+/*
+ * ring_setup
+ * DESCRIPTION: Registers a submission/completion ring in the program's memory
+ * and empties it. The ring size is kept in the PCB too, the copy in the ring
+ * is the program's to scribble on
+ * INPUTS: ring: ring in the program window, entries: power of two up to RING_MAX_ENTRIES
+ * SIDE EFFECTS: resets the ring's indices
+ * RETURN VALUE: 0 on success, -1 for a bad size
+ */
+int32_t ring_setup(io_ring_t* ring, uint32_t entries) {
+	pcb_t* pcb = get_pcb(pid);
+
+	if (entries == 0 || entries > RING_MAX_ENTRIES || (entries & (entries - 1)) != 0)
+		return -1;
+	ring->sq_head = 0;
+	ring->sq_tail = 0;
+	ring->cq_head = 0;
+	ring->cq_tail = 0;
+	ring->entries = entries;
+	pcb->ring = ring;
+	pcb->ring_mask = entries - 1;
+	return 0;
+}
+
+/*
+ * ring_dispatch
+ * DESCRIPTION: Runs one submission through the same fd_ops_t tables
+ * sys_read and sys_write use. The buffer came from the program, so it has to
+ * lie in the program window like any other system call's
+ * INPUTS: sqe: the submission, already copied out of the ring
+ * SIDE EFFECTS: whatever the read or write does, may block
+ * RETURN VALUE: the call's return value, -1 for an unknown opcode or a buffer
+ * outside the program window
+ */
+static int32_t ring_dispatch(ring_sqe_t* sqe) {
+	if (sqe->op != RING_OP_NOP && !user_buffer_ok((const void*) sqe->buf, sqe->nbytes))
+		return -1;
+	switch (sqe->op) {
+	case RING_OP_NOP:
+		return 0;
+	case RING_OP_READ:
+		return sys_read(sqe->fd, (void*) sqe->buf, sqe->nbytes);
+	case RING_OP_WRITE:
+		return sys_write(sqe->fd, (const void*) sqe->buf, sqe->nbytes);
+	}
+	return -1;
+}
+
+/*
+ * ring_enter
+ * DESCRIPTION: Runs queued submissions in order, posting a completion for
+ * each, all in one system call. Stops early when the queue is empty or the
+ * completion queue is full. Indices only ever go through the PCB's mask, so a
+ * program that corrupts its ring only gets back garbage of its own
+ * INPUTS: to_submit: most submissions to run
+ * SIDE EFFECTS: advances sq_head and cq_tail
+ * RETURN VALUE: submissions run, -1 if no ring is registered
+ */
+int32_t ring_enter(uint32_t to_submit) {
+	pcb_t* pcb = get_pcb(pid);
+	io_ring_t* ring = pcb->ring;
+	ring_sqe_t sqe;
+	ring_cqe_t* cqe;
+	uint32_t done;
+
+	if (ring == NULL)
+		return -1;
+	for (done = 0; done < to_submit && ring->sq_head != ring->sq_tail; done++) {
+		if (ring->cq_tail - ring->cq_head > pcb->ring_mask)
+			break;
+		sqe = ring->sqes[ring->sq_head & pcb->ring_mask];
+		ring->sq_head++;
+
+		cqe = &ring->cqes[ring->cq_tail & pcb->ring_mask];
+		cqe->user_data = sqe.user_data;
+		cqe->res = ring_dispatch(&sqe);
+		ring->cq_tail++;
+	}
+	return done;
+}
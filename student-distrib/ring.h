@@ -0,0 +1,44 @@
+#ifndef RING_H
+#define RING_H
+
+#include "types.h"
+
+#define RING_MAX_ENTRIES 64
+
+// submission opcodes
+#define RING_OP_NOP 0
+#define RING_OP_READ 1  // sys_read(fd, buf, nbytes)
+#define RING_OP_WRITE 2 // sys_write(fd, buf, nbytes)
+
+typedef struct ring_sqe {
+	uint32_t op;
+	int32_t fd;
+	uint32_t buf; // user address
+	int32_t nbytes;
+	uint32_t user_data; // copied to the completion
+} ring_sqe_t;
+
+typedef struct ring_cqe {
+	uint32_t user_data;
+	int32_t res; // what the system call would have returned
+} ring_cqe_t;
+
+// lives in the program's memory, the program fills sqes and advances
+// sq_tail, the kernel advances sq_head and cq_tail, the program cq_head
+typedef struct io_ring {
+	uint32_t sq_head;
+	uint32_t sq_tail;
+	uint32_t cq_head;
+	uint32_t cq_tail;
+	uint32_t entries; // power of two, at most RING_MAX_ENTRIES, set by ring_setup
+	ring_sqe_t sqes[RING_MAX_ENTRIES];
+	ring_cqe_t cqes[RING_MAX_ENTRIES];
+} io_ring_t;
+
+// register the current process' ring, replacing any earlier one
+int32_t ring_setup(io_ring_t* ring, uint32_t entries);
+
+// run up to to_submit queued submissions
+int32_t ring_enter(uint32_t to_submit);
+
+#endif // RING_H
@@ -1,95 +1,696 @@
 #include "x86_desc.h"
 #include "paging.h"
 #include "pcb.h"
+#include "syscalls.h"
 #include "syscall_wrapper.h"
 #include "scheduling.h"
+#include "timer.h"
+#include "vdso.h"
 #include "./drivers/keyboard.h"
 
+#define PERCENT 100
+#define PERCENT_SCALE 0xFFFFFF // idle * PERCENT has to fit in 32 bits
+#define SWITCH_AVG_SHIFT 3
+#define SWITCH_SAVED_REGS 4 // ebp, ebx, esi, edi
+
 uint8_t running_proc = 0;
-static uint8_t pit_count = 0;
-uint8_t schedule[BASE_PROC] = { 0 };
+
+static int sched_top_level();
+
+// MLFQ: one FIFO of TASK_RUNNABLE tasks per priority, 0 is the highest.
+// The running task is not on them
+static pcb_t* run_head[SCHED_LEVELS] = { NULL };
+static pcb_t* run_tail[SCHED_LEVELS] = { NULL };
+// base quanta a task may run at each priority before it is demoted
+static const uint32_t quantum[SCHED_LEVELS] = { 1, 2, SCHED_MAX_QUANTA };
+// bumped by every priority reset, tasks off the queues catch up when they next queue
+static uint32_t boost_epoch = 0;
+static uint32_t last_boost_ms = 0;
+// the deadline was pulled in for a higher priority task, not a used up quantum
+static int slice_cut = 0;
+// set once the base shells exist, before that there is no current task
+static int started = 0;
+
+// runs hlt when nothing is runnable, it has no PID and is never on the run queue
+static task_stack_t idle_task;
+// 1 while the idle task is on the CPU, pid still names the last task that ran
+static int idling = 0;
+static uint64_t idle_cycles = 0;
+static uint64_t start_tsc = 0;
+
+// halted spawned task nobody will wait for, freed once the CPU is off it
+static pcb_t* orphan = NULL;
+
+// switches done by schedule() and how long they take
+static uint32_t switches = 0;
+static uint32_t switch_cycles_last = 0;
+static uint32_t switch_cycles_avg = 0;
+
+/*
+ * sched_catch_up
+ * DESCRIPTION: Applies a priority reset that happened while the task was
+ * blocked or waiting for a child
+ * INPUTS: pcb: task
+ * SIDE EFFECTS: may raise the task to priority 0
+ * RETURN VALUE: none
+ */
+static void sched_catch_up(pcb_t* pcb) {
+	if (pcb->boost_epoch != boost_epoch) {
+		pcb->boost_epoch = boost_epoch;
+		pcb->priority = 0;
+	}
+}
+
+/*
+ * sched_init_task
+ * DESCRIPTION: Starts a new program at the highest priority
+ * INPUTS: pcb: task about to run a new program
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+void sched_init_task(pcb_t* pcb) {
+	pcb->priority = 0;
+	pcb->boost_epoch = boost_epoch;
+	memset(&(pcb->stats), 0, sizeof(task_stats_t));
+	pcb->in_kernel = 0;
+	pcb->stamp = rdtsc();
+	pcb->sleep_timer.pending = 0;
+}
+
+/*
+ * sched_charge
+ * DESCRIPTION: Adds the time since the task's last stamp to its user or kernel
+ * time. Interrupts are charged to whatever the task was doing
+ * INPUTS: pcb: running task, now: TSC
+ * SIDE EFFECTS: restamps the task
+ * RETURN VALUE: none
+ */
+static void sched_charge(pcb_t* pcb, uint64_t now) {
+	if (pcb->in_kernel)
+		pcb->stats.kernel_cycles += now - pcb->stamp;
+	else
+		pcb->stats.user_cycles += now - pcb->stamp;
+	pcb->stamp = now;
+}
+
+/*
+ * sched_handoff
+ * DESCRIPTION: Moves the CPU clock from one task to another without going
+ * through schedule, execute hands the CPU to the child and halt back to the parent
+ * INPUTS: from: task giving up the CPU, to: task taking it
+ * SIDE EFFECTS: charges from, restamps to
+ * RETURN VALUE: none
+ */
+void sched_handoff(pcb_t* from, pcb_t* to) {
+	uint64_t now = rdtsc();
+
+	sched_charge(from, now);
+	to->stamp = now;
+	vdso_set_task(to->pid, to->term);
+}
+
+/*
+ * sched_syscall_enter
+ * DESCRIPTION: Called by the system call linkage before the handler, the
+ * current task's time goes to kernel time from here on
+ * INPUTS: none
+ * SIDE EFFECTS: charges the current task
+ * RETURN VALUE: none
+ */
+void sched_syscall_enter() {
+	pcb_t* pcb;
+
+	if (!started || get_task_stack(pid) == NULL)
+		return;
+	pcb = get_pcb(pid);
+	sched_charge(pcb, rdtsc());
+	pcb->in_kernel = 1;
+}
+
+/*
+ * sched_syscall_exit
+ * DESCRIPTION: Called by the system call linkage after the handler, the
+ * current task's time goes to user time from here on
+ * INPUTS: none
+ * SIDE EFFECTS: charges the current task
+ * RETURN VALUE: none
+ */
+void sched_syscall_exit() {
+	pcb_t* pcb;
+
+	if (!started || get_task_stack(pid) == NULL)
+		return;
+	pcb = get_pcb(pid);
+	sched_charge(pcb, rdtsc());
+	pcb->in_kernel = 0;
+}
+
+/*
+ * sched_enqueue
+ * DESCRIPTION: Marks a task runnable and puts it at the back of its priority's queue
+ * INPUTS: pcb: task that is not on the run queue
+ * SIDE EFFECTS: changes the run queue, call with interrupts off
+ * RETURN VALUE: none
+ */
+void sched_enqueue(pcb_t* pcb) {
+	sched_catch_up(pcb);
+	pcb->state = TASK_RUNNABLE;
+	pcb->queued_at = rdtsc();
+	pcb->run_next = NULL;
+	if (run_tail[pcb->priority])
+		run_tail[pcb->priority]->run_next = pcb;
+	else
+		run_head[pcb->priority] = pcb;
+	run_tail[pcb->priority] = pcb;
+}
+
+/*
+ * sched_arm
+ * DESCRIPTION: Sets the timer for the running task's quantum. With nothing else
+ * runnable there is nobody to preempt for, so the timer stays off
+ * INPUTS: pcb: task about to run
+ * SIDE EFFECTS: programs the timer
+ * RETURN VALUE: none
+ */
+static void sched_arm(pcb_t* pcb) {
+	slice_cut = 0;
+	if (sched_top_level() == SCHED_LEVELS) {
+		timer_disarm();
+		return;
+	}
+	timer_arm(quantum[pcb->priority] * timer_get_quantum());
+}
+
+/*
+ * sched_wake
+ * DESCRIPTION: Queues a task that slept, one priority higher since it gave up
+ * the CPU before its quantum ran out. The running task gets a deadline if it
+ * was running alone, or has it pulled in to one quantum if the woken task
+ * outranks it
+ * INPUTS: pcb: task taken off a wait queue
+ * SIDE EFFECTS: changes the run queue, may program the timer, call with interrupts off
+ * RETURN VALUE: none
+ */
+void sched_wake(pcb_t* pcb) {
+	pcb_t* running;
+
+	if (pcb->priority > 0)
+		pcb->priority--;
+	sched_enqueue(pcb);
+
+	// the idle task picks it up on its own
+	if (!started || idling)
+		return;
+	running = get_pcb(pid);
+	if (!timer_armed()) {
+		sched_arm(running);
+	} else if (pcb->priority < running->priority && timer_remaining_ms() > timer_get_quantum()) {
+		timer_arm(timer_get_quantum());
+		slice_cut = 1;
+	}
+}
+
+/*
+ * sched_top_level
+ * DESCRIPTION: Finds the highest priority with a runnable task
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: the priority, SCHED_LEVELS if nothing is runnable
+ */
+static int sched_top_level() {
+	int level;
+
+	for (level = 0; level < SCHED_LEVELS; level++) {
+		if (run_head[level] != NULL)
+			break;
+	}
+	return level;
+}
+
+/*
+ * sched_dequeue
+ * DESCRIPTION: Takes the task at the front of the highest priority queue
+ * INPUTS: none
+ * SIDE EFFECTS: changes the run queue, call with interrupts off
+ * RETURN VALUE: the task, NULL if nothing is runnable
+ */
+static pcb_t* sched_dequeue() {
+	int level = sched_top_level();
+	pcb_t* pcb;
+
+	if (level == SCHED_LEVELS)
+		return NULL;
+	pcb = run_head[level];
+	run_head[level] = pcb->run_next;
+	if (run_head[level] == NULL)
+		run_tail[level] = NULL;
+	pcb->run_next = NULL;
+	return pcb;
+}
+
+/*
+ * sched_boost
+ * DESCRIPTION: Resets every task to priority 0 so demoted tasks cannot starve.
+ * Queued tasks move now, the others when they next queue (sched_catch_up)
+ * INPUTS: none
+ * SIDE EFFECTS: changes the run queue, call with interrupts off
+ * RETURN VALUE: none
+ */
+static void sched_boost() {
+	int level;
+	pcb_t* pcb;
+
+	boost_epoch++;
+	for (level = 1; level < SCHED_LEVELS; level++) {
+		for (pcb = run_head[level]; pcb; pcb = pcb->run_next)
+			pcb->priority = 0;
+		if (run_head[level] == NULL)
+			continue;
+		if (run_tail[0])
+			run_tail[0]->run_next = run_head[level];
+		else
+			run_head[0] = run_head[level];
+		run_tail[0] = run_tail[level];
+		run_head[level] = NULL;
+		run_tail[level] = NULL;
+	}
+	for (pcb = run_head[0]; pcb; pcb = pcb->run_next) {
+		pcb->boost_epoch = boost_epoch;
+	}
+	if (started && !idling)
+		sched_catch_up(get_pcb(pid));
+}
+
+/*
+ * reap_orphan
+ * DESCRIPTION: Frees the orphaned zombie the CPU last switched away from.
+ * Neither its stack nor its page directory may be in use, so this runs on
+ * another task's stack with that task's (or the kernel's) directory loaded
+ * INPUTS: None
+ * SIDE EFFECTS: the PID can be reused, call with interrupts off
+ * RETURN VALUE: None
+ */
+static void reap_orphan() {
+	int dead;
+
+	if (orphan == NULL)
+		return;
+	dead = orphan->pid;
+	orphan = NULL;
+	dealloc_process(dead);
+	free_task_stack(dead);
+}
+
+/*
+ * idle_loop
+ * DESCRIPTION: Body of the idle task. Halts until an interrupt, counting the
+ * cycles spent halted, and hands the CPU over as soon as a task is runnable
+ * INPUTS: None
+ * SIDE EFFECTS: None
+ * RETURN VALUE: never returns
+ */
+static void idle_loop() {
+	uint64_t halted;
+
+	while (1) {
+		cli();
+		if (sched_top_level() != SCHED_LEVELS) {
+			schedule();
+			continue;
+		}
+		if (orphan != NULL) {
+			// the idle task still runs on the directory of whoever it took over from
+			context_switch_paging(KERNEL_PD);
+			reap_orphan();
+		}
+		halted = rdtsc();
+		// sti only takes effect after hlt, so no wake up is missed in between
+		asm volatile ("sti; hlt");
+		idle_cycles += rdtsc() - halted;
+	}
+}
+
+/*
+ * init_task_frame
+ * DESCRIPTION: Builds the frame switch_to pops (edi, esi, ebx, ebp, return
+ * address), so the first switch to a new task starts it at entry
+ * INPUTS: pcb: new task, task_stack: its stack, entry: function it starts in
+ * SIDE EFFECTS: writes the top of the stack
+ * RETURN VALUE: None
+ */
+void init_task_frame(pcb_t* pcb, task_stack_t* task_stack, void (*entry)()) {
+	uint32_t* stack = (uint32_t*) ((uint32_t) task_stack + EIGHT_KB);
+	int i;
+
+	pcb->curr_esp = (uint32_t) stack;
+	*--stack = 0; // entry never returns
+	*--stack = (uint32_t) entry;
+	for (i = 0; i < SWITCH_SAVED_REGS; i++)
+		*--stack = 0;
+	pcb->ksp = (uint32_t) stack;
+}
+
+/*
+ * base_shell_start
+ * DESCRIPTION: (Re)starts the base shell of the current task's terminal in place.
+ * The base shell PIDs are the terminal numbers and stay reserved, so freeing
+ * this one lets execute hand the same PID (and task stack) back
+ * INPUTS: None
+ * SIDE EFFECTS: frees the current program, irets into a new shell
+ * RETURN VALUE: only returns if the shell could not be started
+ */
+void base_shell_start() {
+	cli();
+	zero_base(pid);
+	sys_execute((uint8_t*) "shell");
+}
+
+/*
+ * launch_base_shells
+ * DESCRIPTION: Creates a base shell task for every terminal. Terminal 0's shell
+ * starts right away on the boot stack, the others are queued with a kernel
+ * stack that switch_to returns into base_shell_start on
+ * INPUTS: None
+ * SIDE EFFECTS: reserves PIDs 0 to BASE_PROC - 1, does not return
+ * RETURN VALUE: None
+ */
+void launch_base_shells() {
+	int term, proc_pid;
+	pcb_t* pcb;
+
+	cli();
+	idle_task.task_pcb.pid = -1;
+	idle_task.task_pcb.state = TASK_RUNNING;
+	init_task_frame(&idle_task.task_pcb, &idle_task, idle_loop);
+
+	for (term = 0; term < BASE_PROC; term++) {
+		proc_pid = alloc_new_process();
+		if (proc_pid != term) {
+			printf("Could not reserve base shell PID %d\n", term);
+			return;
+		}
+		pcb = get_pcb(proc_pid);
+		pcb->pid = proc_pid;
+		pcb->parent_id = proc_pid;
+		pcb->term = term;
+		pcb->cr3 = (uint32_t) process_page_directory(proc_pid);
+		sched_init_task(pcb);
+		init_task_frame(pcb, get_task_stack(proc_pid), base_shell_start);
+
+		if (term != 0)
+			sched_enqueue(pcb);
+	}
+
+	pid = 0;
+	running_proc = 0;
+	started = 1;
+	start_tsc = rdtsc();
+	get_pcb(0)->state = TASK_RUNNING;
+	sched_arm(get_pcb(0));
+	base_shell_start();
+}
+
+/*
+ * sched_running
+ * DESCRIPTION: Tells whether there is a current task to block or preempt
+ * INPUTS: None
+ * SIDE EFFECTS: None
+ * RETURN VALUE: 1 once the base shells are launched, 0 before
+ */
+int sched_running() {
+	return started;
+}
+
+/*
+ * sched_yield
+ * DESCRIPTION: Gives up the rest of the quantum to the other runnable tasks of
+ * the same or higher priority. The task keeps its priority, and comes straight
+ * back if there are none
+ * INPUTS: None
+ * SIDE EFFECTS: May switch tasks
+ * RETURN VALUE: None
+ */
+void sched_yield() {
+	uint32_t flags;
+
+	cli_and_save(flags);
+	if (started && !idling) {
+		get_pcb(pid)->state = TASK_RUNNABLE;
+		schedule();
+	}
+	restore_flags(flags);
+}
+
+/*
+ * sched_timeout
+ * DESCRIPTION: Sleep timeout, runs from the timer interrupt
+ * INPUTS: data: the sleeping task
+ * SIDE EFFECTS: queues the task
+ * RETURN VALUE: None
+ */
+static void sched_timeout(void* data) {
+	pcb_t* pcb = (pcb_t*) data;
+
+	if (pcb->state == TASK_BLOCKED)
+		sched_wake(pcb);
+}
+
+/*
+ * sched_sleep
+ * DESCRIPTION: Blocks the current task on a timer wheel entry for at least ms.
+ * The task is on no wait queue, only the timeout wakes it
+ * INPUTS: ms: time to sleep, 0 just yields
+ * SIDE EFFECTS: Switches tasks
+ * RETURN VALUE: None
+ */
+void sched_sleep(uint32_t ms) {
+	pcb_t* pcb;
+	uint32_t flags;
+
+	if (ms == 0 || !started) {
+		sched_yield();
+		return;
+	}
+
+	cli_and_save(flags);
+	pcb = get_pcb(pid);
+	pcb->sleep_timer.fn = sched_timeout;
+	pcb->sleep_timer.data = pcb;
+	timer_add(&(pcb->sleep_timer), ms);
+	while (pcb->sleep_timer.pending) {
+		pcb->state = TASK_BLOCKED;
+		schedule();
+		cli();
+	}
+	restore_flags(flags);
+}
 
 /*
  * context_switch
- * DESCRIPTION: Allows for switching to the next process without halt
+ * DESCRIPTION: Timer deadline. A task that used its whole quantum is demoted,
+ * then preempted if a task of the same or higher priority is runnable. After
+ * BOOST_MS of contended time all tasks go back to priority 0
  * INPUTS: None
- * SIDE EFFECTS: Switches execution to a different process based on round robin scheduling
+ * SIDE EFFECTS: May switch to another task, re-arms the timer otherwise
  * RETURN VALUE: 0
  */
 int context_switch() {
+	pcb_t* pcb;
 
 	cli();
 
-	/* Current Task stack */
-	task_stack_t * task_stack = (task_stack_t*) (K_PAGE_ADDR - (EIGHT_KB * (pid+1)));
-	pcb_t * pcb = &(task_stack->task_pcb);
-
-	/* Save previous process' stack pointer into PCB */
-	asm volatile (
-		"movl %%ebp, %[pcb_ebp]\n\t"
-		: [pcb_ebp] "=g"(pcb->curr_ebp)
-		);
-
-	/* Save previously scheduled screen location */
-	save_screen(running_proc);
-
-	/* Switch to new process & PID */
-	running_proc = (running_proc + 1) % 3;
-	pid = schedule[running_proc];
-
-	/*
-	* First three pit counters should spawn root shell procs
-	* Hopefully people cannot type any other program in shell faster than 35 Hz
-	* If they can I am impressed
-	*/
-	if (pit_count < 3) {
-		/* Save previous process' stack pointer into PCB */
-		asm volatile (
-			"movl %%esp, %[pcb_esp]\n\t"
-			: [pcb_esp] "=g"(pcb->curr_esp)
-			);
-		pit_count++;
-		execute((unsigned char*)"shell");
-	}
-	if (pit_count < 3) {
-		printf("EXTREMLEY SUSS, you managed to return from SHELL");
-	}
-
-	/* Get new paging directory */
-	context_switch_paging(pid);
-
-	/* Gets task stack for new proc */
-	task_stack = (task_stack_t*) (K_PAGE_ADDR - (EIGHT_KB * (pid+1)));
-	pcb = &(task_stack->task_pcb);
-
-	/* Set screen to currently scheduled process */
-	restore_screen(running_proc);
-
-	/* Check current terminal vs proc terminal */
-	if (running_proc != term_num) {
-		remap(running_proc);
-	}
-	else {
-		unmap();
-	}
-
-	/* Switch Stacks and set TSS */
-	asm volatile (
-		"movl %1, %0\n\t"
-		: "=r"(tss.esp0)
-		: "r"(pcb->curr_esp)
-		);
-
-	/* Return into new context */
-	asm volatile (
-		"movl %0, %%ebp\n\t"
-		"leave\n\t"
-		"sti\n\t"
-		"ret\n\t"
-		:
-		: "r"(pcb->curr_ebp)
-		: "ebp"
-		);
+	/* The base shells are not up yet, the idle task schedules on its own */
+	if (!started || idling) {
+		return 0;
+	}
+
+	pcb = get_pcb(pid);
+	if (timer_elapsed_ms() - last_boost_ms >= BOOST_MS) {
+		last_boost_ms = timer_elapsed_ms();
+		sched_boost();
+	}
 
+	/* Used up its quantum, CPU hogs sink */
+	if (!slice_cut && pcb->priority < SCHED_LEVELS - 1) {
+		pcb->priority++;
+	}
+
+	/* Only lower priority tasks (or nothing) to run, keep going */
+	if (sched_top_level() > pcb->priority) {
+		sched_arm(pcb);
+		return 0;
+	}
+
+	schedule();
 	return 0;
 }
+
+/*
+ * sched_switch_done
+ * DESCRIPTION: Records how long a switch took, up to the jump to the next task
+ * INPUTS: start: TSC when schedule was entered
+ * SIDE EFFECTS: updates the switch stats
+ * RETURN VALUE: none
+ */
+static void sched_switch_done(uint64_t start) {
+	switch_cycles_last = (uint32_t) (rdtsc() - start);
+	switch_cycles_avg += ((int32_t) (switch_cycles_last - switch_cycles_avg)) >> SWITCH_AVG_SHIFT;
+	switches++;
+}
+
+/*
+ * schedule
+ * DESCRIPTION: Switches to the task at the front of the highest priority queue.
+ * A running or yielding task goes to the back of its queue, a blocked one stays
+ * off it. When nothing is runnable the idle task runs. It keeps the last task's
+ * paging, screen and TSS since it only touches kernel memory
+ * INPUTS: None
+ * SIDE EFFECTS: Switches screen, TSS and (in switch_to) kernel stack and page
+ * directory to the next task, returns when this task is picked again
+ * RETURN VALUE: None
+ */
+void schedule() {
+	uint64_t now = rdtsc();
+	pcb_t* prev;
+	pcb_t* next;
+
+	cli();
+
+	prev = idling ? &(idle_task.task_pcb) : get_pcb(pid);
+
+	/* A zombie left last time is off the CPU now, unless the idle task still has its directory */
+	if (!idling)
+		reap_orphan();
+
+	/* Preempted task goes to the back of the queue */
+	if (!idling) {
+		save_screen(running_proc);
+		sched_charge(prev, now);
+		if (prev->state == TASK_RUNNING) {
+			prev->stats.involuntary++;
+			sched_enqueue(prev);
+		} else if (prev->state == TASK_RUNNABLE) {
+			/* Yielded */
+			prev->stats.voluntary++;
+			sched_enqueue(prev);
+		} else {
+			prev->stats.voluntary++;
+			if (prev->state == TASK_ZOMBIE && prev->parent_id == -1)
+				orphan = prev;
+		}
+	}
+
+	next = sched_dequeue();
+	if (next == NULL) {
+		/* Nothing runnable, the idle task waits for an interrupt to wake one */
+		next = &(idle_task.task_pcb);
+		timer_disarm();
+	} else {
+		/* Switch to new process & PID */
+		next->state = TASK_RUNNING;
+		pid = next->pid;
+		running_proc = next->term;
+		vdso_set_task(next->pid, next->term);
+		sched_arm(next);
+		next->stats.wait_cycles += now - next->queued_at;
+		next->stamp = now;
+
+		/* switch_to loads the page directory */
+		paging_set_pid(pid);
+
+		/* Set screen to currently scheduled process */
+		restore_screen(running_proc);
+
+		/* Check current terminal vs proc terminal */
+		if (running_proc != term_num) {
+			remap(running_proc);
+		}
+		else {
+			unmap();
+		}
+
+		/* Kernel stack for the next trap from user mode */
+		tss.esp0 = next->curr_esp;
+	}
+	idling = (next == &(idle_task.task_pcb));
+
+	/* Picked again straight away, nothing to switch */
+	if (next == prev) {
+		return;
+	}
+
+	sched_switch_done(now);
+	switch_to(prev, next);
+}
+
+/*
+ * sched_get_info
+ * DESCRIPTION: Snapshot of the scheduler counters and every live task's stats.
+ * The running task is charged up to now first
+ * INPUTS: info: where to put it
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+void sched_get_info(sched_info_t* info) {
+	uint32_t flags;
+	int i, n = 0;
+	pcb_t* pcb;
+
+	cli_and_save(flags);
+	info->now = rdtsc();
+	if (started && !idling && get_task_stack(pid) != NULL)
+		sched_charge(get_pcb(pid), info->now);
+	info->idle_cycles = idle_cycles;
+	info->switches = switches;
+	info->switch_cycles_last = switch_cycles_last;
+	info->switch_cycles_avg = switch_cycles_avg;
+	info->timer_interrupts = timer_get_stats()->interrupts;
+	for (i = 0; i < MAX_PROCESSES && n < STATS_MAX_TASKS; i++) {
+		if (get_task_stack(i) == NULL)
+			continue;
+		pcb = get_pcb(i);
+		info->tasks[n].pid = pcb->pid;
+		info->tasks[n].parent_id = pcb->parent_id;
+		info->tasks[n].term = pcb->term;
+		info->tasks[n].state = pcb->state;
+		info->tasks[n].priority = pcb->priority;
+		strncpy((int8_t*) info->tasks[n].cmd, (int8_t*) pcb->cmd, STATS_CMD_LEN - 1);
+		info->tasks[n].cmd[STATS_CMD_LEN - 1] = '\0';
+		info->tasks[n].stats = pcb->stats;
+		n++;
+	}
+	info->task_count = n;
+	restore_flags(flags);
+}
+
+/*
+ * print_cpu_usage
+ * DESCRIPTION: Prints how much of the time since the base shells started the
+ * CPU spent running tasks, as opposed to halted in the idle task
+ * INPUTS: None
+ * SIDE EFFECTS: prints to the screen
+ * RETURN VALUE: None
+ */
+void print_cpu_usage() {
+	uint64_t total, idle;
+	uint32_t flags, idle_percent;
+
+	cli_and_save(flags);
+	total = rdtsc() - start_tsc;
+	idle = idle_cycles;
+	restore_flags(flags);
+
+	// no 64 bit division in the kernel, scale both down until the percent fits
+	while (total > PERCENT_SCALE) {
+		total >>= 1;
+		idle >>= 1;
+	}
+	if (!started || total == 0) {
+		printf("CPU usage not measured yet\n");
+		return;
+	}
+	idle_percent = (uint32_t) idle * PERCENT / (uint32_t) total;
+	printf("CPU %u%% busy, %u%% idle\n", PERCENT - idle_percent, idle_percent);
+	printf("timer: %u interrupts, %u deadlines, %u ms contended, quantum %u ms\n", timer_get_stats()->interrupts,
+		timer_get_stats()->expiries, timer_elapsed_ms(), timer_get_quantum());
+}
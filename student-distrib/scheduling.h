@@ -1,10 +1,85 @@
 #ifndef SCHEDULE
 #define SCHEDULE
 
+#include "pcb.h"
+
 #define BASE_PROC 3
+#define SCHED_LEVELS 3 // MLFQ priorities
+#define SCHED_MAX_QUANTA 4 // quanta a task at the lowest priority runs for
+#define BOOST_MS 2000 // every task is reset to priority 0 after this much contended time
+#define STATS_MAX_TASKS 16
+#define STATS_CMD_LEN 32
+
+// one task in the stats system call
+typedef struct task_info {
+	int32_t pid;
+	int32_t parent_id;
+	int32_t term;
+	int32_t state;
+	int32_t priority;
+	uint8_t cmd[STATS_CMD_LEN];
+	task_stats_t stats;
+} task_info_t;
+
+// what the stats system call copies out, times are TSC cycles
+typedef struct sched_info {
+	uint64_t now;
+	uint64_t idle_cycles;
+	uint32_t switches;
+	uint32_t switch_cycles_last; // schedule() entry to the next task running
+	uint32_t switch_cycles_avg;  // moving average, 1/8 weight per switch
+	uint32_t timer_interrupts;
+	uint32_t task_count;
+	task_info_t tasks[STATS_MAX_TASKS];
+} sched_info_t;
 
-extern uint8_t schedule[BASE_PROC];
 extern uint8_t running_proc;
 int context_switch();
 
+// build a new task's first switch_to frame, it starts running at entry
+void init_task_frame(pcb_t* pcb, task_stack_t* task_stack, void (*entry)());
+
+// save prev's registers and stack, continue on next's (switch.S)
+void switch_to(pcb_t* prev, pcb_t* next);
+
+// give up the CPU, a task that is not TASK_RUNNING stays off the run queue
+void schedule();
+
+// back of the run queue if another task of the same or higher priority is runnable
+void sched_yield();
+
+// block the current task for at least ms
+void sched_sleep(uint32_t ms);
+
+// 1 once there is a current task to block or preempt
+int sched_running();
+
+// charge from's time up to now and start to's clock, for execute and halt
+void sched_handoff(pcb_t* from, pcb_t* to);
+
+// system call entry and exit, moves the current task's time between user and kernel
+void sched_syscall_enter();
+void sched_syscall_exit();
+
+// fill in scheduler and per task stats
+void sched_get_info(sched_info_t* info);
+
+// print busy and idle time since the base shells started
+void print_cpu_usage();
+
+// start a new program at the highest priority
+void sched_init_task(pcb_t* pcb);
+
+// put a task at the back of its priority's run queue
+void sched_enqueue(pcb_t* pcb);
+
+// queue a task that slept, one priority higher
+void sched_wake(pcb_t* pcb);
+
+// (re)start the base shell of the current task's terminal
+void base_shell_start();
+
+// start a base shell on every terminal, does not return
+void launch_base_shells();
+
 #endif
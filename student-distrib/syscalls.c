@@ -8,6 +8,11 @@
 #include "drivers/terminal.h"
 #include "paging.h"
 #include "scheduling.h"
+#include "tlb.h"
+#include "trace.h"
+#include "kmalloc.h"
+#include "pipe.h"
+#include "wait.h"
 
 // jump table ptrs for file fd's
 static fd_ops_t file_syscalls = {
@@ -44,8 +49,113 @@ static fd_ops_t file_stdout = {
 	.close = terminal_close
 };
 
+// jump table ptrs for the read end of a pipe
+static fd_ops_t pipe_read_syscalls = {
+	.read = pipe_read,
+	.write = pipe_bad_write,
+	.close = pipe_close_read
+};
+
+// jump table ptrs for the write end of a pipe
+static fd_ops_t pipe_write_syscalls = {
+	.read = pipe_bad_read,
+	.write = pipe_write,
+	.close = pipe_close_write
+};
+
 static uint8_t clear_count = 0;
 
+/*
+ * user_buffer_ok
+ * DESCRIPTION: checks a buffer lies inside the program window
+ * INPUTS: buf: user address, size: bytes
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 1 if it does, 0 if not
+ */
+int user_buffer_ok(const void* buf, uint32_t size) {
+	uint32_t start = (uint32_t) buf;
+
+	return start >= BASE_VIRT_ADDR && size <= FOUR_MIB && start + size <= BASE_VIRT_ADDR + FOUR_MIB;
+}
+
+/*
+ * close_all_files
+ * DESCRIPTION: closes every descriptor a halting process still has open, while
+ * it is still the current process (pipe ends look themselves up by pid)
+ * INPUTS: pcb: the current process
+ * SIDE EFFECTS: calls each close function, empties the descriptor array
+ * RETURN VALUE: none
+ */
+static void close_all_files(pcb_t* pcb) {
+	int fd;
+
+	for (fd = 0; fd < MAX_FILES; fd++) {
+		if ((pcb->fd_array[fd]).flags & FD_USED)
+			(pcb->fd_array)[fd].table_pointer.close(fd);
+	}
+	memset(pcb->fd_array, 0, sizeof(pcb->fd_array));
+}
+
+/*
+ * reap
+ * DESCRIPTION: frees a halted spawned process' pages, PID and task stack. It
+ * is off the CPU for good, so its stack can go
+ * INPUTS: child: PID of a TASK_ZOMBIE
+ * SIDE EFFECTS: the PID can be reused
+ * RETURN VALUE: none
+ */
+static void reap(int child) {
+	dealloc_process(child);
+	free_task_stack(child);
+}
+
+/*
+ * disown_children
+ * DESCRIPTION: a halting process will never wait for its spawned children, the
+ * halted ones are reaped now and the scheduler frees the rest once they halt.
+ * Interrupts stay off so no child can halt between its check and being disowned
+ * INPUTS: parent: PID of the halting process
+ * SIDE EFFECTS: frees zombies, marks running children as orphans
+ * RETURN VALUE: none
+ */
+static void disown_children(int parent) {
+	pcb_t* child;
+	uint32_t flags;
+	int i;
+
+	cli_and_save(flags);
+	for (i = BASE_PROC; i < MAX_PROCESSES; i++) {
+		if (i == parent || get_task_stack(i) == NULL)
+			continue;
+		child = get_pcb(i);
+		if (!child->spawned || child->parent_id != parent)
+			continue;
+		if (child->state == TASK_ZOMBIE)
+			reap(i);
+		else
+			child->parent_id = -1;
+	}
+	restore_flags(flags);
+}
+
+/*
+ * spawn_exit
+ * DESCRIPTION: halt for a spawned process. Nobody sleeps in execute for it, so
+ * it becomes a zombie for its parent's wait and gives up the CPU for good. An
+ * orphan (parent_id -1) is freed by the scheduler once it has switched away
+ * INPUTS: pcb: the current process, status: value for wait
+ * SIDE EFFECTS: wakes the parent if it is waiting, never returns
+ * RETURN VALUE: none
+ */
+static void spawn_exit(pcb_t* pcb, uint32_t status) {
+	cli();
+	pcb->exit_status = status;
+	pcb->state = TASK_ZOMBIE;
+	if (pcb->parent_id != -1)
+		wake_up(&(get_pcb(pcb->parent_id)->child_wq));
+	schedule();
+}
+
 /*
  * sys_halt
  * DESCRIPTION: terminates a process, returning the specified value to its parent process
@@ -58,7 +168,7 @@ int32_t sys_halt (uint8_t status) {
 	uint32_t local_status = status;
 
 	// Get current task stack and PCB
-	task_stack_t * curr_task_stack = (task_stack_t*) (K_PAGE_ADDR - (EIGHT_KB * (pid+1)));
+	task_stack_t * curr_task_stack = get_task_stack(pid);
 	pcb_t* curr_pcb = &(curr_task_stack->task_pcb);
 
 	// Check status
@@ -67,13 +177,25 @@ int32_t sys_halt (uint8_t status) {
 
 	// Disable video enabled flag if enabled
 	if (curr_pcb->vid_flag == 1) {
-		page_table_vid[(VID_PAGE_START >> 12) & 0x3FF] = 0;
+		tlb_set_entry(&page_table_vid[(VID_PAGE_START >> 12) & 0x3FF], 0, VID_PAGE_START);
+	}
+
+	// Program pages go away with the process, the image stays cached
+	image_put(curr_pcb->image);
+	curr_pcb->image = NULL;
+
+	// Close files while this is still the current process, pipe ends need it
+	close_all_files(curr_pcb);
+	disown_children(curr_pcb->pid);
+
+	// Spawned processes have no parent sleeping in execute
+	if (curr_pcb->spawned) {
+		spawn_exit(curr_pcb, local_status);
 	}
 
 	// If in base shell relaunch
-	if (pid < 3) {
-		zero_base(term_num);
-		sys_execute((uint8_t *) "shell");
+	if (pid < BASE_PROC) {
+		base_shell_start();
 		return 0;
 	}
 
@@ -91,23 +213,18 @@ int32_t sys_halt (uint8_t status) {
 	// Restore parent pid
 	pid = curr_pcb->parent_id;
 
-	// Call close on all the files
-	int fd;
-	for(fd = 0; fd < MAX_FD; fd++){
-		if((curr_pcb->fd_array[fd]).flags & FD_USED){
-			(curr_pcb->fd_array)[fd].table_pointer.close(fd);
-		}
-	}
-
-	// Purge PCB's FD
-	memset(curr_pcb->fd_array, 0, sizeof(curr_pcb->fd_array));
-
 	// Restore Parent Data (esp0) and return to where execute was called
 	tss.esp0 = curr_pcb->par_esp;
 
-	// Go back to parent pid in schedule
+	// Parent takes over this task's place on the CPU
 	cli();
-	schedule[running_proc] = curr_pcb->parent_id;
+	get_pcb(curr_pcb->parent_id)->state = TASK_RUNNING;
+	sched_handoff(curr_pcb, get_pcb(curr_pcb->parent_id));
+
+	// PCB and kernel stack go back to the cache, nothing reuses them before the ret below
+	uint32_t par_ebp = curr_pcb->par_ebp;
+	free_task_stack(curr_pcb->pid);
+
 	// Go back to execute that started child program with return status
 	asm volatile(
 			"movl %0, %%eax;"
@@ -116,7 +233,7 @@ int32_t sys_halt (uint8_t status) {
 			"sti;"
 			"ret;"
 			:
-			: "r" (local_status), "r" ((curr_pcb->par_ebp))
+			: "r" (local_status), "r" (par_ebp)
 			: "memory", "cc"
 	);
 
@@ -124,47 +241,23 @@ int32_t sys_halt (uint8_t status) {
 }
 
 /*
- * sys_execute
- * DESCRIPTION: attempts to load and execute a new program, hands the processor to the new program until it terminates
- * INPUTS: command: a space-separated sequence of words
- * The first word is the file name of the program to be executed.
- * The rest of the command should be provided to the new program on request via the getargs system call.
- * SIDE EFFECTS:
- * RETURN VALUE: -1 if unexecutable, 256 if dies by exception,
- * 0 to 255 if the program executes a halt system call, given by the program’s call to halt
+ * load_command
+ * DESCRIPTION: splits a command into the program name and its argument and
+ * finds the program's cached image
+ * INPUTS: command: a space-separated sequence of words, tmp_cmd/tmp_arg: BUF_LEN buffers to fill
+ * SIDE EFFECTS: takes a reference on the image
+ * RETURN VALUE: the image, NULL if the program does not exist or is not executable
  */
-int32_t sys_execute (const uint8_t* command) {
-
+static program_image_t* load_command(const uint8_t* command, uint8_t* tmp_cmd, uint8_t* tmp_arg) {
 	// Counter vars
 	int i = 0;
 	int j = 1;
 	int k = 0;
 	int l = 0;
 
-	// Temporary arrays to hold cmd and arg and store into pcb
-	uint8_t tmp_cmd[BUF_LEN];
-	uint8_t tmp_arg[BUF_LEN];
-	int offset = 0;
-
 	// Filesys Dentry
 	dentry_t curr_dentry = {{ 0 }};
 
-	// Magic string at start of ELF file
-	char magic_string[4] = { 0x7F, 'E', 'L', 'F' };
-
-	// ELF Headers
-	uint32_t curr_elf_header[10] = { 0 };
-	uint32_t user_entry = 0;
-
-	// User address stack and base pointer
-	uint32_t user_esp = 0;
-
-	cli();
-
-	if (command == NULL) {
-		return -1;
-	}
-
 	// zero tmp cmd and args buffers
 	for (k = 0; k < BUF_LEN; k++) {
 		tmp_cmd[k] = '\0';
@@ -197,51 +290,126 @@ int32_t sys_execute (const uint8_t* command) {
 	read_dentry_by_name (tmp_cmd, &curr_dentry);
 	if (curr_dentry.filetype != 2) {
 		// printf("Filetype incorrect!!!!\n");
-		return -1;
+		return NULL;
 	}
 
-	// Read program header
-	read_data (curr_dentry.inode_num, 0, curr_elf_header, sizeof(curr_elf_header) / sizeof(char));
+	// ELF headers are only parsed the first time this executable runs
+	return image_get(curr_dentry.inode_num);
+}
+
+/*
+ * init_child
+ * DESCRIPTION: fills in a new process' PCB, execute and spawn then set up its
+ * descriptors and how it first gets onto the CPU
+ * INPUTS: child: its PCB, proc_pid: its PID, image: program, term: terminal,
+ * tmp_cmd/tmp_arg: program name and argument
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+static void init_child(pcb_t* child, int proc_pid, program_image_t* image, int term, uint8_t* tmp_cmd, uint8_t* tmp_arg) {
+	memset(child->fd_array, 0, sizeof(child->fd_array));
+	child->parent_id = pid;
+	child->pid = proc_pid;
+	child->vid_flag = 0;
+	child->ring = NULL;
+	child->spawned = 0;
+	// program pages are mapped from this image on first touch (page_in)
+	child->image = image;
+	child->term = term;
+	sched_init_task(child);
+	strcpy((int8_t*) child->arg, (int8_t*) tmp_arg);
+	strcpy((int8_t*) child->cmd, (int8_t*) tmp_cmd);
+	trace_task_start(proc_pid, child->cmd);
+
+	// page directory the scheduler switches to
+	child->cr3 = (uint32_t) process_page_directory(proc_pid);
+}
 
-	// Verify executable string
-	if (strncmp((const char*) curr_elf_header, magic_string, 4)) {
-		printf("MAGIC STRING WRONG!!!!\n");
+/*
+ * enter_user
+ * DESCRIPTION: irets into a freshly loaded program at its entry point, with
+ * an empty user stack at the top of the program window
+ * INPUTS: user_entry: ELF entry point
+ * SIDE EFFECTS: leaves the kernel
+ * RETURN VALUE: none, never returns
+ */
+static void enter_user(uint32_t user_entry) {
+	// Setup user stack address
+	uint32_t user_esp = BASE_VIRT_ADDR + FOUR_MIB - 4;
+
+	asm volatile (
+		"cli\n\t"
+		"mov $0x2B, %%ax\n\t"
+		"mov %%ax, %%ds\n\t"
+		"mov %%ax, %%es\n\t"
+		"mov %%ax, %%fs\n\t"
+		"mov %%ax, %%gs\n\t"
+		"pushl $0x2B\n\t"
+		"pushl %[user_esp]\n\t"
+		"pushfl\n\t"
+		"popl %%eax\n\t"
+		"orl $0x200, %%eax\n\t"
+		"pushl %%eax\n\t"
+		"pushl $0x23\n\t"
+		"pushl %[entry]\n\t"
+		"iret\n\t"
+		:
+		: [entry] "g"(user_entry), [user_esp] "g"(user_esp)
+		: "eax"
+		);
+}
+
+/*
+ * sys_execute
+ * DESCRIPTION: attempts to load and execute a new program, hands the processor to the new program until it terminates
+ * INPUTS: command: a space-separated sequence of words
+ * The first word is the file name of the program to be executed.
+ * The rest of the command should be provided to the new program on request via the getargs system call.
+ * SIDE EFFECTS:
+ * RETURN VALUE: -1 if unexecutable, 256 if dies by exception,
+ * 0 to 255 if the program executes a halt system call, given by the program’s call to halt
+ */
+int32_t sys_execute (const uint8_t* command) {
+
+	// Temporary arrays to hold cmd and arg and store into pcb
+	uint8_t tmp_cmd[BUF_LEN];
+	uint8_t tmp_arg[BUF_LEN];
+
+	// Cached program image
+	program_image_t* image;
+
+	cli();
+
+	if (command == NULL) {
 		return -1;
 	}
 
-	// Entry to program is right after header
-	user_entry = curr_elf_header[6];
+	image = load_command(command, tmp_cmd, tmp_arg);
+	if (image == NULL) {
+		return -1;
+	}
 
 	// Allocate new PID
 	int proc_pid = alloc_new_process();
 	if (proc_pid == -1) {
 		// printf("PID COULD NOT BE ALLOCATED");
+		image_put(image);
 		return -1;
 	}
 
-	// If shell, set scheduled process to process pid
-	if (proc_pid < 3) {
-		running_proc = proc_pid;
-	}
+	// Base shells own their terminal, everything else runs in its parent's
+	pcb_t* par_pcb = get_pcb(pid);
+	int term = (proc_pid < BASE_PROC) ? proc_pid : par_pcb->term;
+	running_proc = term;
 
 	// Setup child proc paging structs
 	context_switch_paging(proc_pid);
 
-	// Zero program memory location (prevents nonsense)
-	memset((void*) PROGRAM_VIRT_START, 0, PROGRAM_SIZE);
-
-	// Load ELF into memory
-	i = read_data(curr_dentry.inode_num, offset, (void *)(PROGRAM_VIRT_START+offset), 4096);
-	while (0 != i) {
-		offset += i;
-		i = read_data(curr_dentry.inode_num, offset, (void *)(PROGRAM_VIRT_START+offset), 4096);
-	}
-
-	// Setup user stack address
-	user_esp = BASE_VIRT_ADDR + FOUR_MIB - 4;
-
 	// PCB Address pointers parent and child
-	task_stack_t * const task_stack = (task_stack_t*) (K_PAGE_ADDR - (EIGHT_KB * (proc_pid+1)));
+	task_stack_t * const task_stack = get_task_stack(proc_pid);
+
+	// Setting PCB parameters for child process
+	init_child(&(task_stack->task_pcb), proc_pid, image, term, tmp_cmd, tmp_arg);
 
 	// file descriptor set up for 0 and 1
 	fd_t * file_array = task_stack->task_pcb.fd_array;
@@ -250,22 +418,14 @@ int32_t sys_execute (const uint8_t* command) {
 	(file_array+1)->table_pointer = file_stdout;
 	(file_array+1)->flags |= FD_USED;
 
-	// Setting PCB parameters for child process
-	task_stack->task_pcb.parent_id = pid;
-	task_stack->task_pcb.pid = proc_pid;
-	task_stack->task_pcb.vid_flag = 0;
-	strcpy((int8_t*) task_stack->task_pcb.arg, (int8_t*) tmp_arg);
-	strcpy((int8_t*) task_stack->task_pcb.cmd, (int8_t*) tmp_cmd);
-
 	// Setting global PID to process PID
 	pid = proc_pid;
 
 	// TSS Setup for context switch with PCB init
-	tss.esp0 = K_PAGE_ADDR - (EIGHT_KB * (proc_pid));
+	tss.esp0 = (uint32_t) task_stack + EIGHT_KB;
 
-	// Initialize proc stack pointer to top of stack
+	// Kernel stack top the scheduler switches to
 	task_stack->task_pcb.curr_esp = tss.esp0;
-	task_stack->task_pcb.curr_ebp = task_stack->task_pcb.curr_esp;
 
 	// Saving parent stack pointers into child PCB
 	asm volatile ("\n\
@@ -277,8 +437,12 @@ int32_t sys_execute (const uint8_t* command) {
 		: "memory", "cc"
 	);
 
-	// Replace currently scheduled program for given terminal with new process
-	schedule[running_proc] = proc_pid;
+	// Parent sleeps in execute until the child halts, the child runs in its place.
+	// execute has to return the child's status, so it stays a foreground call,
+	// programs that run alongside their parent are started with sys_spawn
+	par_pcb->state = TASK_WAITING;
+	task_stack->task_pcb.state = TASK_RUNNING;
+	sched_handoff(par_pcb, &(task_stack->task_pcb));
 
 	// Map video mem based on process' associated term
 	if (running_proc != term_num) {
@@ -297,26 +461,7 @@ int32_t sys_execute (const uint8_t* command) {
 
 
 	// IRET Context to user setup
-	asm volatile (
-		"cli\n\t"
-		"mov $0x2B, %%ax\n\t"
-		"mov %%ax, %%ds\n\t"
-		"mov %%ax, %%es\n\t"
-		"mov %%ax, %%fs\n\t"
-		"mov %%ax, %%gs\n\t"
-		"pushl $0x2B\n\t"
-		"pushl %[user_esp]\n\t"
-		"pushfl\n\t"
-		"popl %%eax\n\t"
-		"orl $0x200, %%eax\n\t"
-		"pushl %%eax\n\t"
-		"pushl $0x23\n\t"
-		"pushl %[entry]\n\t"
-		"iret\n\t"
-		:
-		: [entry] "g"(user_entry), [user_esp] "g"(user_esp)
-		: "eax"
-		);
+	enter_user(image->entry);
 
 	return 0;
 }
@@ -538,37 +683,345 @@ int32_t sys_vidmap (uint8_t** screen_start) {
 	* Fill in PDE for new Page table using most significant 10 bits
 	* For this paging Entry:
 	* 11-9 Avail, 8 G, 7 BIG_PAGE, 6 '0', 5 Accessed, 4 Cache Disabled, 3 PWT, 2 U/S, 1 R/W, 0 P
-	*     000      1     0            0          0              0          0      1       1    1
-	* which is 0x107 for last 12 bits
+	*     000      0     0            0          0              0          0      1       1    1
+	* which is 0x007 for last 12 bits
 	* First 24 bits is page table address
 	*/
-	cur_pd[VID_PAGE_START >> 22] = ((uint32_t) page_table_vid)  | USER_SPACE | WRITE_ENABLE | PRESENT;
+	tlb_set_entry(&cur_pd[VID_PAGE_START >> 22], ((uint32_t) page_table_vid) | USER_SPACE | WRITE_ENABLE | PRESENT, VID_PAGE_START);
 
 	/*
 	* Fill in entry for address middle 10 bits, which ids the page index for video mem
 	* For this paging entry
 	* 11-9 Avail, 8 G, 7 BIG_PAGE, 6 '0', 5 Accessed, 4 Cache Disabled, 3 PWT, 2 U/S, 1 R/W, 0 P
-	*     000      1     0            0          0              0          0      1       1    1
-	* which is 0x107 for the last 12 bits
+	*     000      0     0            0          0              0          0      1       1    1
+	* which is 0x007 for the last 12 bits (user mapping, so not global)
 	* B8 for next eight bits to represent VGA 4KB aligned address
 	*/
-	page_table_vid[(VID_PAGE_START >> 12) & 0x3FF] = 0xB8107;
+	tlb_set_entry(&page_table_vid[(VID_PAGE_START >> 12) & 0x3FF], VIDMEM_PAGE_FULL, VID_PAGE_START);
 
 	// store video page address into given pointer
 	*screen_start = (uint8_t *) VID_PAGE_START;
 
-    // Flush TLBs
-    asm volatile (
-        "movl %%cr3, %%eax\n\t"
-        "movl %%eax, %%cr3\n\t"
-        :
-        :
-        : "eax"
-        );
+	return 0;
+}
+
+/*
+ * sys_stats
+ * DESCRIPTION: copies the scheduler counters and per task CPU time, switch counts
+ * and run queue wait time to a user buffer
+ * INPUTS: info: user buffer for a sched_info_t
+ * SIDE EFFECTS: none
+ * RETURN VALUE: number of tasks reported, -1 if info is not a user address
+ */
+int32_t sys_stats (sched_info_t* info) {
+	if (!user_buffer_ok(info, sizeof(sched_info_t)))
+		return -1;
+	sched_get_info(info);
+	return info->task_count;
+}
 
+/*
+ * sys_yield
+ * DESCRIPTION: lets other runnable tasks of the same or higher priority run first
+ * INPUTS: none
+ * SIDE EFFECTS: may switch tasks
+ * RETURN VALUE: 0
+ */
+int32_t sys_yield (void) {
+	sched_yield();
 	return 0;
 }
 
+/*
+ * sys_sleep
+ * DESCRIPTION: blocks the calling task for at least ms, rounded up to whole
+ * timer wheel ticks
+ * INPUTS: ms: time to sleep, 0 yields, at most MAX_TIMEOUT_MS
+ * SIDE EFFECTS: switches tasks
+ * RETURN VALUE: 0, -1 if ms is too long
+ */
+int32_t sys_sleep (uint32_t ms) {
+	if (ms > MAX_TIMEOUT_MS)
+		return -1;
+	sched_sleep(ms);
+	return 0;
+}
+
+/*
+ * sys_gettime
+ * DESCRIPTION: reads the TSC based monotonic or wall clock, to the ns
+ * INPUTS: clock_id: CLOCK_MONOTONIC or CLOCK_REALTIME, ts: user buffer for a timespec_t
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 0, -1 for an unknown clock or if ts is not a user address
+ */
+int32_t sys_gettime (uint32_t clock_id, timespec_t* ts) {
+	if (!user_buffer_ok(ts, sizeof(timespec_t)))
+		return -1;
+	return clock_gettime(clock_id, ts);
+}
+
+/*
+ * sys_trace
+ * DESCRIPTION: switches system call tracing on and off and reads what it
+ * recorded: recent calls, per call latency histograms and per pid counts
+ * INPUTS: cmd: TRACE_*, buf: user buffer for the read commands, nbytes: its size
+ * SIDE EFFECTS: TRACE_ON clears what was recorded
+ * RETURN VALUE: entries copied for TRACE_READ and TRACE_TASKS, otherwise 0,
+ * -1 for a bad command or buffer
+ */
+int32_t sys_trace (int32_t cmd, void* buf, int32_t nbytes) {
+	if (cmd >= TRACE_READ && (nbytes < 0 || !user_buffer_ok(buf, nbytes)))
+		return -1;
+	return trace_control(cmd, buf, nbytes);
+}
+
+/*
+ * sys_ring_setup
+ * DESCRIPTION: registers a submission/completion ring, so batches of reads
+ * and writes cost one system call (sys_ring_enter)
+ * INPUTS: ring: ring in the program's memory, entries: power of two up to RING_MAX_ENTRIES
+ * SIDE EFFECTS: empties the ring
+ * RETURN VALUE: 0, -1 for a bad ring or size
+ */
+int32_t sys_ring_setup (io_ring_t* ring, uint32_t entries) {
+	if (!user_buffer_ok(ring, sizeof(io_ring_t)))
+		return -1;
+	return ring_setup(ring, entries);
+}
+
+/*
+ * sys_ring_enter
+ * DESCRIPTION: runs queued submissions and posts their completions
+ * INPUTS: to_submit: most submissions to run
+ * SIDE EFFECTS: the reads and writes submitted, may block
+ * RETURN VALUE: submissions run, -1 if no ring is registered
+ */
+int32_t sys_ring_enter (uint32_t to_submit) {
+	return ring_enter(to_submit);
+}
+
+/*
+ * iov_fetch
+ * DESCRIPTION: copies a readv/writev vector into the kernel and checks every
+ * piece lies in the program window
+ * INPUTS: fd: descriptor it is for, iov: user vector, iovcnt: pieces, kiov: IOV_MAX pieces to fill
+ * SIDE EFFECTS: none
+ * RETURN VALUE: total bytes capped at IOV_MAX_BYTES, -1 for a bad fd or vector
+ */
+static int32_t iov_fetch (uint32_t fd, const iovec_t* iov, int32_t iovcnt, iovec_t* kiov) {
+	uint32_t total = 0;
+	int32_t i;
+
+	if (fd > MAX_FD || !(get_pcb(pid)->fd_array[fd].flags & FD_USED))
+		return -1;
+	if (iovcnt < 0 || iovcnt > IOV_MAX || !user_buffer_ok(iov, iovcnt * sizeof(iovec_t)))
+		return -1;
+	memcpy(kiov, iov, iovcnt * sizeof(iovec_t));
+	for (i = 0; i < iovcnt; i++) {
+		if (!user_buffer_ok(kiov[i].base, kiov[i].len))
+			return -1;
+		total += kiov[i].len; // each len is at most 4 MiB, no overflow
+	}
+	return (total > IOV_MAX_BYTES) ? IOV_MAX_BYTES : total;
+}
+
+/*
+ * sys_readv
+ * DESCRIPTION: reads into several buffers with one call of the fd's read
+ * handler, through a bounce buffer, so the pieces see one contiguous read
+ * INPUTS: fd: descriptor, iov: buffers, iovcnt: how many (at most IOV_MAX)
+ * SIDE EFFECTS: calls the read function once, may block
+ * RETURN VALUE: bytes read (at most IOV_MAX_BYTES), -1 on failure
+ */
+int32_t sys_readv (uint32_t fd, const iovec_t* iov, int32_t iovcnt) {
+	iovec_t kiov[IOV_MAX];
+	uint8_t* bounce;
+	int32_t total, ret, done, chunk, i;
+
+	total = iov_fetch(fd, iov, iovcnt, kiov);
+	if (total <= 0)
+		return total;
+	bounce = kmalloc(total);
+	if (bounce == NULL)
+		return -1;
+	ret = get_pcb(pid)->fd_array[fd].table_pointer.read(fd, bounce, total);
+
+	// scatter what came back
+	for (i = 0, done = 0; i < iovcnt && done < ret; i++, done += chunk) {
+		chunk = (kiov[i].len < (uint32_t) (ret - done)) ? kiov[i].len : ret - done;
+		memcpy(kiov[i].base, bounce + done, chunk);
+	}
+	kfree(bounce);
+	return ret;
+}
+
+/*
+ * sys_writev
+ * DESCRIPTION: gathers several buffers and hands them to the fd's write
+ * handler in one call, so the terminal prints (and moves the cursor) once
+ * INPUTS: fd: descriptor, iov: buffers, iovcnt: how many (at most IOV_MAX)
+ * SIDE EFFECTS: calls the write function once
+ * RETURN VALUE: bytes written (at most IOV_MAX_BYTES), -1 on failure
+ */
+int32_t sys_writev (uint32_t fd, const iovec_t* iov, int32_t iovcnt) {
+	iovec_t kiov[IOV_MAX];
+	uint8_t* bounce;
+	int32_t total, ret, done, chunk, i;
+
+	total = iov_fetch(fd, iov, iovcnt, kiov);
+	if (total <= 0)
+		return total;
+	bounce = kmalloc(total);
+	if (bounce == NULL)
+		return -1;
+	for (i = 0, done = 0; i < iovcnt && done < total; i++, done += chunk) {
+		chunk = (kiov[i].len < (uint32_t) (total - done)) ? kiov[i].len : total - done;
+		memcpy(bounce + done, kiov[i].base, chunk);
+	}
+	ret = get_pcb(pid)->fd_array[fd].table_pointer.write(fd, bounce, total);
+	kfree(bounce);
+	return ret;
+}
+
+/*
+ * sys_pipe
+ * DESCRIPTION: creates a pipe and opens both ends in the current process
+ * INPUTS: fds: two ints, filled with the read end then the write end
+ * SIDE EFFECTS: takes two descriptors
+ * RETURN VALUE: 0, -1 for a bad buffer, too few free descriptors or no memory
+ */
+int32_t sys_pipe (int32_t* fds) {
+	pcb_t* curr_pcb = get_pcb(pid);
+	int32_t ends[2];
+	pipe_t* p;
+	int i, n = 0;
+
+	if (!user_buffer_ok(fds, 2 * sizeof(int32_t)))
+		return -1;
+	for (i = 2; i < MAX_FILES && n < 2; i++) {
+		if (!(curr_pcb->fd_array[i].flags & FD_USED))
+			ends[n++] = i;
+	}
+	if (n < 2)
+		return -1;
+	p = pipe_create();
+	if (p == NULL)
+		return -1;
+
+	curr_pcb->fd_array[ends[0]].table_pointer = pipe_read_syscalls;
+	curr_pcb->fd_array[ends[1]].table_pointer = pipe_write_syscalls;
+	for (i = 0; i < 2; i++) {
+		curr_pcb->fd_array[ends[i]].inode_num = -1;
+		curr_pcb->fd_array[ends[i]].file_position = 0;
+		curr_pcb->fd_array[ends[i]].pipe = p;
+		curr_pcb->fd_array[ends[i]].flags |= FD_USED;
+		fds[i] = ends[i];
+	}
+	return 0;
+}
+
+/*
+ * spawn_start
+ * DESCRIPTION: where a spawned process starts, the first time the scheduler
+ * switches to it. Paging, screen and esp0 are already its own
+ * INPUTS: none
+ * SIDE EFFECTS: enters the program
+ * RETURN VALUE: none, never returns
+ */
+static void spawn_start() {
+	enter_user(get_pcb(pid)->image->entry);
+}
+
+/*
+ * sys_spawn
+ * DESCRIPTION: starts a program that runs alongside the caller instead of in
+ * its place, with copies of two of the caller's descriptors as its 0 and 1.
+ * The caller collects its status with sys_wait
+ * INPUTS: command: as for execute, in_fd/out_fd: the child's stdin and stdout
+ * SIDE EFFECTS: queues the new process
+ * RETURN VALUE: its PID, -1 if unexecutable or a descriptor is not open
+ */
+int32_t sys_spawn (const uint8_t* command, int32_t in_fd, int32_t out_fd) {
+	uint8_t tmp_cmd[BUF_LEN];
+	uint8_t tmp_arg[BUF_LEN];
+	pcb_t* par_pcb = get_pcb(pid);
+	program_image_t* image;
+	pcb_t* child;
+	uint32_t flags;
+	int proc_pid;
+
+	if (command == NULL || in_fd < 0 || in_fd > MAX_FD || out_fd < 0 || out_fd > MAX_FD)
+		return -1;
+	if (!(par_pcb->fd_array[in_fd].flags & FD_USED) || !(par_pcb->fd_array[out_fd].flags & FD_USED))
+		return -1;
+
+	image = load_command(command, tmp_cmd, tmp_arg);
+	if (image == NULL)
+		return -1;
+	proc_pid = alloc_new_process();
+	if (proc_pid == -1) {
+		image_put(image);
+		return -1;
+	}
+
+	child = get_pcb(proc_pid);
+	init_child(child, proc_pid, image, par_pcb->term, tmp_cmd, tmp_arg);
+	child->spawned = 1;
+	child->fd_array[0] = par_pcb->fd_array[in_fd];
+	child->fd_array[1] = par_pcb->fd_array[out_fd];
+	pipe_dup(&(child->fd_array[0]));
+	pipe_dup(&(child->fd_array[1]));
+	init_task_frame(child, get_task_stack(proc_pid), spawn_start);
+
+	cli_and_save(flags);
+	sched_wake(child);
+	restore_flags(flags);
+	return proc_pid;
+}
+
+/*
+ * sys_wait
+ * DESCRIPTION: sleeps until a spawned child halts, then frees it
+ * INPUTS: child_pid: PID sys_spawn returned to this process
+ * SIDE EFFECTS: may block, the PID can be reused afterwards
+ * RETURN VALUE: the child's status as execute would return it, -1 if it is not a spawned child of the caller
+ */
+int32_t sys_wait (int32_t child_pid) {
+	pcb_t* child;
+	uint32_t flags;
+	int32_t status;
+
+	if (child_pid < BASE_PROC || child_pid >= MAX_PROCESSES || child_pid == pid || get_task_stack(child_pid) == NULL)
+		return -1;
+	child = get_pcb(child_pid);
+	if (!child->spawned || child->parent_id != pid)
+		return -1;
+
+	cli_and_save(flags);
+	while (child->state != TASK_ZOMBIE)
+		sleep_on(&(get_pcb(pid)->child_wq));
+	status = child->exit_status;
+	reap(child_pid);
+	restore_flags(flags);
+	return status;
+}
+
+/*
+ * sys_isatty
+ * DESCRIPTION: tells whether a descriptor is the terminal, so a program can
+ * tell the keyboard from a pipe on its standard input
+ * INPUTS: fd: descriptor
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 1 for the terminal, 0 for anything else, -1 if fd is not open
+ */
+int32_t sys_isatty (uint32_t fd) {
+	pcb_t* curr_pcb = get_pcb(pid);
+
+	if (fd > MAX_FD || !(curr_pcb->fd_array[fd].flags & FD_USED))
+		return -1;
+	return curr_pcb->fd_array[fd].table_pointer.read == terminal_read || curr_pcb->fd_array[fd].table_pointer.write == terminal_write;
+}
+
 int32_t sys_set_handler (int32_t signum, void* handler_address) {
 	// TODO: EXTRA CREDIT
 	return -1;
@@ -3,33 +3,53 @@
 
 #include "types.h"
 #include "fd.h"
+#include "scheduling.h"
+#include "clock.h"
+#include "ring.h"
+#include "sysnum.h"
 
-#define SYS_HALT 1
-#define SYS_EXECUTE 2
-#define SYS_READ 3
-#define SYS_WRITE 4
-#define SYS_OPEN 5
-#define SYS_CLOSE 6
-#define SYS_GETARGS 7
-#define SYS_VIDMAP 8
-#define SYS_SET_HANDLER 9
-#define SYS_SIGRETURN 10
 #define SYS_ERROR_STAT 256
 
 #define MAX_FD 7
 #define EXCEPTION_ERROR 69
 #define FD_USED 0x80000000
 #define PROGRAM_VIRT_START 0x08048000
-#define PROGRAM_SIZE 0x400000-0x48000
 #define SPACE 32
 #define TAB 9
 
 #define ELF_HEADER 0x28
+#define ELF_MAGIC_LEN 4
+#define PT_LOAD 1
 #define FOUR_KB 0x1000
 #define FOUR_MIB 0x400000
 #define EIGHT_MIB 0x800000
 #define BASE_VIRT_ADDR 0x08000000
 #define BUF_LEN 128
+#define IOV_MAX 16
+#define IOV_MAX_BYTES 0x1000 // bounce buffer size, longer vectors get a short read or write
+
+// one piece of a readv/writev buffer
+typedef struct iovec {
+	void* base;
+	uint32_t len;
+} iovec_t;
+
+typedef struct __attribute__((packed)) elf_header {
+	uint8_t e_ident[16]; // Magic string, class, data encoding
+	uint16_t e_type; // Object file type
+	uint16_t e_machine; // Architecture
+	uint32_t e_version; // Object file version
+	uint32_t e_entry; // Virtual address of the first instruction
+	uint32_t e_phoff; // Offset of the program header table in fileimage
+	uint32_t e_shoff; // Offset of the section header table No Need
+	uint32_t e_flags; // Processor specific flags
+	uint16_t e_ehsize; // Size of this header
+	uint16_t e_phentsize; // Size of one program header
+	uint16_t e_phnum; // Number of program headers
+	uint16_t e_shentsize; // Section header size No Need
+	uint16_t e_shnum; // Number of section headers No Need
+	uint16_t e_shstrndx; // Section name string table index No Need
+} elf_header_t;
 
 typedef struct __attribute__((packed)) program_header {
 	uint32_t p_type; // Type of segment
@@ -42,6 +62,9 @@ typedef struct __attribute__((packed)) program_header {
 	uint32_t p_align; // If not 0 or 1, where p_vaddr = p_offset - p_align
 } program_header_t;
 
+// 1 if buf..buf+size lies inside the program window
+int user_buffer_ok(const void* buf, uint32_t size);
+
 int32_t sys_halt (uint8_t status); // syscall #1
 int32_t sys_execute (const uint8_t* command); // syscall #2
 int32_t sys_read (uint32_t fd, void* buf, int32_t nbytes); // syscall #3
@@ -52,5 +75,18 @@ int32_t sys_getargs (uint8_t* buf, int32_t nbytes); // syscall #7
 int32_t sys_vidmap (uint8_t** screen_start); // syscall #8
 int32_t sys_set_handler (int32_t signum, void* handler_address); // syscall #9
 int32_t sys_sigreturn (void); // syscall #10
+int32_t sys_stats (sched_info_t* info); // syscall #11
+int32_t sys_yield (void); // syscall #12
+int32_t sys_sleep (uint32_t ms); // syscall #13
+int32_t sys_gettime (uint32_t clock_id, timespec_t* ts); // syscall #14
+int32_t sys_trace (int32_t cmd, void* buf, int32_t nbytes); // syscall #15
+int32_t sys_ring_setup (io_ring_t* ring, uint32_t entries); // syscall #16
+int32_t sys_ring_enter (uint32_t to_submit); // syscall #17
+int32_t sys_readv (uint32_t fd, const iovec_t* iov, int32_t iovcnt); // syscall #18
+int32_t sys_writev (uint32_t fd, const iovec_t* iov, int32_t iovcnt); // syscall #19
+int32_t sys_pipe (int32_t* fds); // syscall #20
+int32_t sys_spawn (const uint8_t* command, int32_t in_fd, int32_t out_fd); // syscall #21
+int32_t sys_wait (int32_t child_pid); // syscall #22
+int32_t sys_isatty (uint32_t fd); // syscall #23
 
 #endif
@@ -5,13 +5,33 @@
 #include "drivers/terminal.h"
 #include "drivers/rtc.h"
 #include "paging.h"
+#include "pcb.h"
+#include "image_cache.h"
+#include "frame.h"
+#include "kmalloc.h"
+#include "tlb.h"
+#include "timer.h"
+#include "clock.h"
+#include "vdso.h"
+#include "scheduling.h"
 #include "syscall_wrapper.h"
+#include "idt.h"
+#include "handlers.h"
+#include "trace.h"
+#include "ring.h"
+#include "pipe.h"
+#include "syscalls.h"
 
 #define PASS 1
 #define FAIL 0
 
 #define CHECKNUM 5
 #define CHECKNUM2 2
+#define BENCH_SWITCHES 1000
+#define BENCH_FRAMES 8
+#define BENCH_READS 100
+#define READ_TEST_BYTES 0x10000
+#define IOV_TEST_WINDOW 0x083F0000 // in the stack part of the program window
 
 /* format these macros as you see fit */
 #define TEST_HEADER 	\
@@ -384,6 +404,16 @@ int virtual_to_physical_test(){
 	return result;
 }
 
+/* touch_user_page
+ * Faults in a stack page of an exe-less process so it can be translated
+ * Inputs: pid whose PD is loaded, user address to touch
+ * Outputs: value read
+ */
+static int touch_user_page(int pid, uint32_t addr){
+	get_pcb(pid)->image = NULL;
+	return *(volatile int*)addr;
+}
+
 /* Page Alloc/Context Switch Test
  *
  * Page alloc and check using mem info
@@ -395,64 +425,78 @@ int virtual_to_physical_test(){
  */
 int page_alloc_context_switch_test() {
 	TEST_HEADER;
-	int pid;
+	int pid, i, j;
+	int pids[4];
+	uint32_t phys[4];
+	uint32_t free_before;
+
+	// the first process may create a task stack slab the cache keeps afterwards,
+	// so count free frames once one has come and gone
+	pid = alloc_new_process();
+	if (pid == -1)
+		return FAIL;
+	dealloc_process(pid);
+	free_task_stack(pid);
+	free_before = frame_free_count();
+
 	// create new process
 	pid = alloc_new_process();
 	// switch to process PD
 	if (pid == -1 || context_switch_paging(pid) == -1){
 		return FAIL;
 	}
-	// check mem mapping is okay
-	if(virtual_to_physical(0x80420B0) != 0x8420B0){
+	// check mem mapping is okay (pages are mapped on first touch)
+	touch_user_page(pid, 0x83FF0B0);
+	if((virtual_to_physical(0x83FF0B0) & SMALL_PAGE_MASK) != 0x0B0 || process_resident_pages(pid, NULL) != 1){
 		return FAIL;
 	}
-
-	// switch back to kernal PD to remove process
-	if (context_switch_paging(6) == -1){
-		return FAIL;
-	}
-	// remove data in process PD
-	if (dealloc_process(pid) == -1){
+	// pages that are neither program nor stack are never mapped
+	if (page_in(0x80420B0) != -1 || virtual_to_physical(0x80420B0) != INVALID_ADDR){
 		return FAIL;
 	}
 
-	// test allocating multiple PDs
-	pid = alloc_new_process();
-	if (pid == -1 || context_switch_paging(pid) == -1){
-		return FAIL;
-	}
-	// check mem mapping is okay
-	if(virtual_to_physical(0x80420B0) != 0x8420B0){
+	// switch back to kernal PD to remove process
+	if (context_switch_paging(KERNEL_PD) == -1){
 		return FAIL;
 	}
-
-	pid = alloc_new_process();
-	if (pid == -1 || context_switch_paging(pid) == -1){
+	// remove data in process PD, its PD, PT and stack page go back, the task
+	// stack stays with the PID until it is freed as well
+	if (dealloc_process(pid) == -1){
 		return FAIL;
 	}
-	// check mem mapping is okay
-	if(virtual_to_physical(0x80420B0) != 0xC420B0){
+	free_task_stack(pid);
+	if (frame_free_count() != free_before){
 		return FAIL;
 	}
 
-	pid = alloc_new_process();
-	if (pid == -1 || context_switch_paging(pid) == -1){
-		return FAIL;
-	}
-	// check mem mapping is okay
-	if(virtual_to_physical(0x80420B0) != 0x10420B0){
-		return FAIL;
+	// test allocating multiple PDs, each gets its own frames
+	for (i = 0; i < 4; i++){
+		pids[i] = alloc_new_process();
+		if (pids[i] == -1 || context_switch_paging(pids[i]) == -1){
+			return FAIL;
+		}
+		// check mem mapping is okay (pages are mapped on first touch)
+		touch_user_page(pids[i], 0x83FF0B0);
+		phys[i] = virtual_to_physical(0x83FF0B0);
+		if((phys[i] & SMALL_PAGE_MASK) != 0x0B0){
+			return FAIL;
+		}
+		for (j = 0; j < i; j++){
+			if (phys[j] == phys[i]){
+				return FAIL;
+			}
+		}
 	}
 
-	pid = alloc_new_process();
-	if (pid == -1 || context_switch_paging(pid) == -1){
+	// give all four back so later tests start from the same memory
+	if (context_switch_paging(KERNEL_PD) == -1){
 		return FAIL;
 	}
-	// check mem mapping is okay
-	if(virtual_to_physical(0x80420B0) != 0x14420B0){
-		return FAIL;
+	for (i = 0; i < 4; i++){
+		dealloc_process(pids[i]);
+		free_task_stack(pids[i]);
 	}
-	return PASS;
+	return frame_free_count() == free_before ? PASS : FAIL;
 }
 
 /* System call tests */
@@ -506,6 +550,1019 @@ int syscall_vidmap() {
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
 
+/* Dentry Lookup Test
+ *
+ * Checks the hashed name index finds every file and rejects unknown names
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ * Coverage: read_dentry_by_name, read_dentry_by_index
+ * Files: filesystem.c
+ */
+int dentry_lookup_test(){
+	TEST_HEADER;
+	dentry_t by_index, by_name;
+	uint32_t i;
+
+	// every listed file must be found by name and resolve to the same inode
+	for (i = 0; i < MAX_DENTRIES; i++) {
+		if (read_dentry_by_index(i, &by_index) == -1 || by_index.filename[0] == '\0')
+			break;
+		if (read_dentry_by_name((uint8_t *) by_index.filename, &by_name) == -1)
+			return FAIL;
+		if (by_name.inode_num != by_index.inode_num || by_name.filetype != by_index.filetype)
+			return FAIL;
+	}
+
+	// misses (including a typo of a real name) must fail
+	if (read_dentry_by_name((uint8_t *) "shel", &by_name) != -1)
+		return FAIL;
+	if (read_dentry_by_name((uint8_t *) "magic_file", &by_name) != -1)
+		return FAIL;
+
+	// names longer than 32 chars match on the first 32 like the old scan did
+	if (read_dentry_by_name((uint8_t *) "verylargetextwithverylongname.txt", &by_name) == -1)
+		return FAIL;
+	return PASS;
+}
+
+/* Extent Read Test
+ *
+ * Reads every regular file whole, and the long text file at offsets around
+ * its block boundary, through read_data and the per block path, and checks
+ * they agree byte for byte
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ * Coverage: read_data, read_data_blocks
+ * Files: filesystem.c
+ */
+static uint8_t read_fast[READ_TEST_BYTES];
+static uint8_t read_slow[READ_TEST_BYTES];
+static const uint32_t read_offsets[] = { 0, 1, 4000, 4095, 4096, 4097, 5000 };
+static const uint32_t read_lengths[] = { 1, 96, 200, 4096, 8192 };
+
+// 1 if the first n bytes of a and b match
+static int bytes_equal(const uint8_t* a, const uint8_t* b, uint32_t n) {
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		if (a[i] != b[i])
+			return 0;
+	}
+	return 1;
+}
+
+int extent_read_test(){
+	TEST_HEADER;
+	dentry_t dentry;
+	int32_t fast, slow;
+	uint32_t i, j, k, len;
+
+	for (i = 0; i < MAX_DENTRIES; i++) {
+		if (read_dentry_by_index(i, &dentry) == -1 || dentry.filename[0] == '\0')
+			break;
+		if (dentry.filetype != 2)
+			continue;
+		len = read_inode_size(dentry.inode_num);
+		if (len > READ_TEST_BYTES)
+			len = READ_TEST_BYTES;
+		memset(read_fast, 0, len);
+		memset(read_slow, 0xFF, len);
+		fast = read_data(dentry.inode_num, 0, read_fast, len);
+		slow = read_data_blocks(dentry.inode_num, 0, read_slow, len);
+		if (fast != slow || !bytes_equal(read_fast, read_slow, len))
+			return FAIL;
+	}
+
+	// 5277 bytes over two blocks, reads starting before, on and after the boundary
+	if (read_dentry_by_name((uint8_t *) "verylargetextwithverylongname.txt", &dentry) == -1)
+		return FAIL;
+	for (j = 0; j < sizeof(read_offsets) / sizeof(read_offsets[0]); j++) {
+		for (k = 0; k < sizeof(read_lengths) / sizeof(read_lengths[0]); k++) {
+			memset(read_fast, 0, read_lengths[k]);
+			memset(read_slow, 0xFF, read_lengths[k]);
+			fast = read_data(dentry.inode_num, read_offsets[j], read_fast, read_lengths[k]);
+			slow = read_data_blocks(dentry.inode_num, read_offsets[j], read_slow, read_lengths[k]);
+			if (fast != slow || fast < 0 || !bytes_equal(read_fast, read_slow, fast))
+				return FAIL;
+		}
+	}
+	return PASS;
+}
+
+/* Extent Read Benchmark
+ *
+ * Times whole file reads of the largest file through the extents and one
+ * block at a time
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Prints cycles per read for both paths
+ * Coverage: read_data, read_data_blocks
+ * Files: filesystem.c
+ */
+int extent_read_benchmark(){
+	TEST_HEADER;
+	dentry_t dentry, largest;
+	int8_t name[FILESYSTEM_NAME_MAX + 1];
+	uint32_t cycles[2];
+	uint32_t flags, i, len = 0;
+	uint64_t start;
+
+	for (i = 0; i < MAX_DENTRIES; i++) {
+		if (read_dentry_by_index(i, &dentry) == -1 || dentry.filename[0] == '\0')
+			break;
+		if (dentry.filetype == 2 && read_inode_size(dentry.inode_num) > len) {
+			len = read_inode_size(dentry.inode_num);
+			largest = dentry;
+		}
+	}
+	if (len == 0)
+		return FAIL;
+	if (len > READ_TEST_BYTES)
+		len = READ_TEST_BYTES;
+
+	cli_and_save(flags);
+	start = rdtsc();
+	for (i = 0; i < BENCH_READS; i++)
+		read_data(largest.inode_num, 0, read_fast, len);
+	cycles[0] = (uint32_t)(rdtsc() - start) / BENCH_READS;
+	start = rdtsc();
+	for (i = 0; i < BENCH_READS; i++)
+		read_data_blocks(largest.inode_num, 0, read_slow, len);
+	cycles[1] = (uint32_t)(rdtsc() - start) / BENCH_READS;
+	restore_flags(flags);
+
+	strncpy(name, largest.filename, FILESYSTEM_NAME_MAX);
+	name[FILESYSTEM_NAME_MAX] = '\0';
+	printf("%s, %u bytes: %u cycles per read with extents, %u per block\n",
+		name, len, cycles[0], cycles[1]);
+	return bytes_equal(read_fast, read_slow, len) ? PASS : FAIL;
+}
+
+/* Image Cache Test
+ *
+ * Checks repeated lookups of one executable share a single cached image
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Parses shell's headers into the cache if not already there
+ * Coverage: image_get, image_put
+ * Files: image_cache.c
+ */
+int image_cache_test(){
+	TEST_HEADER;
+	dentry_t shell;
+	program_image_t* first;
+	program_image_t* second;
+	uint32_t refs;
+	int result = PASS;
+
+	if (read_dentry_by_name((uint8_t *) "shell", &shell) == -1)
+		return FAIL;
+	first = image_get(shell.inode_num);
+	if (first == NULL)
+		return FAIL;
+	refs = first->refs;
+	second = image_get(shell.inode_num);
+
+	// second lookup is a hit on the same entry, parsed once
+	if (second != first || second->refs != refs + 1 || first->seg_count == 0)
+		result = FAIL;
+	image_put(second);
+	image_put(first);
+
+	// non executables are never cached
+	if (read_dentry_by_name((uint8_t *) "frame0.txt", &shell) == -1 || image_get(shell.inode_num) != NULL)
+		result = FAIL;
+	return result;
+}
+
+/* Frame Alloc Test
+ *
+ * Checks buddy blocks are aligned to their size and merge back when freed
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ * Coverage: frame_alloc, frame_free
+ * Files: frame.c
+ */
+int frame_alloc_test(){
+	TEST_HEADER;
+	uint32_t free_before = frame_free_count();
+	uint32_t small, pair, big;
+	int result = PASS;
+
+	small = frame_alloc(0);
+	pair = frame_alloc(1);
+	big = frame_alloc(MAX_FRAME_ORDER);
+	if (small == NO_FRAME || pair == NO_FRAME || big == NO_FRAME)
+		result = FAIL;
+	// blocks are naturally aligned, slabs find their header by masking
+	if ((pair & (2 * FRAME_SIZE - 1)) || (big & BIG_PAGE_MASK))
+		result = FAIL;
+	if (frame_free_count() != free_before - 1 - 2 - (1 << MAX_FRAME_ORDER))
+		result = FAIL;
+	// everything merges back, so the largest block is available again
+	frame_free(big, MAX_FRAME_ORDER);
+	frame_free(pair, 1);
+	frame_free(small, 0);
+	if (frame_free_count() != free_before)
+		result = FAIL;
+	if (frame_alloc(MAX_FRAME_ORDER + 1) != NO_FRAME)
+		result = FAIL;
+	return result;
+}
+
+/* Kmalloc Test
+ *
+ * Checks cache objects and large blocks are distinct and all memory comes back
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Creates a test cache (caches are never destroyed)
+ * Coverage: kmalloc, kfree, kmem_cache_alloc, kmem_cache_free
+ * Files: kmalloc.c
+ */
+int kmalloc_test(){
+	TEST_HEADER;
+	static kmem_cache_t* big_cache = NULL;
+	uint8_t* small[8];
+	void* objs[16];
+	uint8_t* large;
+	uint32_t free_before, diff;
+	int i, j;
+	int result = PASS;
+
+	if (big_cache == NULL)
+		big_cache = kmem_cache_create((const int8_t*) "test_8k", EIGHT_KB);
+	if (big_cache == NULL)
+		return FAIL;
+	free_before = frame_free_count();
+
+	// one of each kmalloc size, plus one too big for the caches
+	for (i = 0; i < 8; i++) {
+		small[i] = kmalloc(KMALLOC_MIN_SIZE << i);
+		if (small[i] == NULL)
+			result = FAIL;
+		else
+			memset(small[i], i, KMALLOC_MIN_SIZE << i);
+	}
+	for (i = 0; i < 8; i++) {
+		for (j = 0; j < (KMALLOC_MIN_SIZE << i); j++) {
+			if (small[i] && small[i][j] != i)
+				result = FAIL;
+		}
+	}
+	large = small[7];
+	if (large == NULL || ((uint32_t) large & (FRAME_SIZE - 1)) == 0)
+		result = FAIL;
+
+	// more objects than one slab holds, none may overlap
+	for (i = 0; i < 16; i++) {
+		objs[i] = kmem_cache_alloc(big_cache);
+		if (objs[i] == NULL)
+			result = FAIL;
+		for (j = 0; j < i; j++) {
+			diff = (uint32_t) objs[i] > (uint32_t) objs[j] ? (uint32_t) objs[i] - (uint32_t) objs[j] : (uint32_t) objs[j] - (uint32_t) objs[i];
+			if (objs[i] && objs[j] && diff < EIGHT_KB)
+				result = FAIL;
+		}
+	}
+	if (big_cache->in_use != 16 || big_cache->slabs < 16 / big_cache->per_slab)
+		result = FAIL;
+
+	for (i = 0; i < 16; i++)
+		kmem_cache_free(big_cache, objs[i]);
+	for (i = 0; i < 8; i++)
+		kfree(small[i]);
+	if (big_cache->in_use != 0 || big_cache->slabs != 1)
+		result = FAIL;
+	// only the slabs kept for next time may be missing
+	if (frame_free_count() + 32 < free_before)
+		result = FAIL;
+	return result;
+}
+
+/* TLB Test
+ *
+ * Checks video remaps invalidate single pages and skip unchanged mappings
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Leaves video memory mapped to the screen
+ * Coverage: remap, unmap, tlb_set_entry
+ * Files: paging.c, tlb.c
+ */
+int tlb_test(){
+	TEST_HEADER;
+	tlb_stats_t before, after;
+	int result = PASS;
+
+	unmap(0);
+	tlb_get_stats(&before);
+	// nothing changed, so nothing is flushed
+	unmap(0);
+	tlb_get_stats(&after);
+	if (after.skipped != before.skipped + 2 || after.page_flushes != before.page_flushes)
+		result = FAIL;
+
+	// switching to a terminal buffer and back invalidates just the two video pages each time
+	remap(1);
+	unmap(0);
+	tlb_get_stats(&after);
+	if (after.page_flushes != before.page_flushes + 4 || after.full_flushes != before.full_flushes)
+		result = FAIL;
+	if (virtual_to_physical(VIDMEM_ADDR << 12) != (VIDMEM_ADDR << 12))
+		result = FAIL;
+	return result;
+}
+
+/* touch_kernel_pages
+ * Reads a word from each page of a kernel working set: video memory, the
+ * terminal buffers and a few direct mapped frames
+ * Inputs: frames to read, count
+ * Outputs: sum of the words read (keeps the reads from being dropped)
+ */
+static uint32_t touch_kernel_pages(uint32_t* frames, int count){
+	uint32_t sum = 0;
+	int i;
+	for (i = VIDMEM_ADDR; i <= TERMINAL_2_VIDPAGE; i++)
+		sum += *(volatile uint32_t*)(i << 12);
+	for (i = 0; i < count; i++)
+		sum += *(volatile uint32_t*)frames[i];
+	return sum;
+}
+
+/* Context Switch Benchmark
+ *
+ * Times page directory switches between two processes, each followed by a pass
+ * over a kernel working set, with global pages off and then on. With PGE the
+ * kernel's translations survive the cr3 write instead of being walked again
+ * Inputs: None
+ * Outputs: PASS, cycles per switch are printed
+ * Side Effects: Toggles CR4.PGE (leaving it on), loads the kernel PD
+ * Coverage: Global pages
+ * Files: paging.c
+ */
+int context_switch_benchmark(){
+	TEST_HEADER;
+	uint32_t frames[BENCH_FRAMES];
+	uint32_t cycles[2];
+	uint32_t cr4;
+	uint64_t start;
+	int a, b, pge, i;
+	int result = PASS;
+
+	a = alloc_new_process();
+	b = alloc_new_process();
+	for (i = 0; i < BENCH_FRAMES; i++) {
+		frames[i] = frame_alloc(0);
+		if (frames[i] == NO_FRAME)
+			result = FAIL;
+	}
+	if (a == -1 || b == -1)
+		result = FAIL;
+
+	for (pge = 0; pge < 2 && result == PASS; pge++) {
+		// writing PGE also flushes every global entry, so both runs start cold
+		asm volatile("mov %%cr4, %0": "=r"(cr4));
+		cr4 = pge ? (cr4 | CR4_PGE) : (cr4 & ~CR4_PGE);
+		asm volatile("mov %0, %%cr4":: "r"(cr4));
+
+		start = rdtsc();
+		for (i = 0; i < BENCH_SWITCHES; i++) {
+			context_switch_paging(i & 1 ? b : a);
+			touch_kernel_pages(frames, BENCH_FRAMES);
+		}
+		cycles[pge] = (uint32_t)(rdtsc() - start) / BENCH_SWITCHES;
+	}
+	printf("cycles per switch: %u without global pages, %u with\n", cycles[0], cycles[1]);
+
+	context_switch_paging(KERNEL_PD);
+	dealloc_process(a);
+	dealloc_process(b);
+	for (i = 0; i < BENCH_FRAMES; i++)
+		frame_free(frames[i], 0);
+	return result;
+}
+
+
+// partner task for switch_to_benchmark, it bounces every switch straight back
+static task_stack_t bench_stack;
+static pcb_t bench_main;
+static volatile uint32_t bench_bounces;
+
+/* bench_partner
+ * Body of the partner task: counts and switches back to the benchmark
+ * Inputs: None
+ * Outputs: never returns
+ */
+static void bench_partner(){
+	while (1) {
+		bench_bounces++;
+		switch_to(&bench_stack.task_pcb, &bench_main);
+	}
+}
+
+/* switch_to Benchmark
+ *
+ * Bounces between the test and a partner kernel task with switch_to, first
+ * within one address space and then with each side on its own page directory
+ * Inputs: None
+ * Outputs: PASS if every switch came back, cycles per switch are printed
+ * Side Effects: Loads the kernel PD, interrupts are off while timing
+ * Coverage: switch_to, init_task_frame
+ * Files: switch.S, scheduling.c
+ */
+int switch_to_benchmark(){
+	TEST_HEADER;
+	uint32_t cycles[2];
+	uint32_t flags;
+	uint64_t start;
+	int a, b, cr3, i;
+	int result = PASS;
+
+	a = alloc_new_process();
+	b = alloc_new_process();
+	if (a == -1 || b == -1)
+		return FAIL;
+
+	cli_and_save(flags);
+	for (cr3 = 0; cr3 < 2; cr3++) {
+		// 0 keeps the loaded directory, like the idle task
+		bench_main.cr3 = cr3 ? (uint32_t) process_page_directory(a) : 0;
+		bench_stack.task_pcb.cr3 = cr3 ? (uint32_t) process_page_directory(b) : 0;
+		init_task_frame(&bench_stack.task_pcb, &bench_stack, bench_partner);
+		bench_bounces = 0;
+
+		start = rdtsc();
+		for (i = 0; i < BENCH_SWITCHES; i++)
+			switch_to(&bench_main, &bench_stack.task_pcb);
+		// each round trip is two switches
+		cycles[cr3] = (uint32_t)(rdtsc() - start) / (2 * BENCH_SWITCHES);
+		if (bench_bounces != BENCH_SWITCHES)
+			result = FAIL;
+	}
+	restore_flags(flags);
+	printf("cycles per switch_to: %u same address space, %u with cr3 load\n", cycles[0], cycles[1]);
+
+	context_switch_paging(KERNEL_PD);
+	dealloc_process(a);
+	dealloc_process(b);
+	return result;
+}
+
+/* Timer Test
+ *
+ * Checks one-shot deadlines, including one longer than a single PIT count
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Programs the PIT, enables interrupts while waiting
+ * Coverage: timer_arm, timer_disarm, timer_remaining_ms, timer_set_quantum
+ * Files: timer.c, drivers/pit.c
+ */
+int timer_test(){
+	TEST_HEADER;
+	timer_stats_t before = *timer_get_stats();
+	uint32_t elapsed = timer_elapsed_ms();
+	uint32_t left;
+	int result = PASS;
+
+	if (timer_set_quantum(0) != -1 || timer_set_quantum(MAX_QUANTUM_MS + 1) != -1)
+		result = FAIL;
+	if (timer_get_quantum() != DEFAULT_QUANTUM_MS)
+		result = FAIL;
+
+	// an armed deadline counts down and can be cancelled
+	cli();
+	timer_arm(40);
+	left = timer_remaining_ms();
+	if (!timer_armed() || left > 40 || left < 30)
+		result = FAIL;
+	timer_disarm();
+	if (timer_armed() || timer_remaining_ms() != 0)
+		result = FAIL;
+
+	// 120 ms takes three PIT shots but reaches the scheduler once
+	timer_arm(120);
+	sti();
+	while (timer_armed())
+		asm volatile ("hlt");
+	if (timer_get_stats()->expiries != before.expiries + 1 || timer_get_stats()->interrupts < before.interrupts + 3)
+		result = FAIL;
+	if (timer_elapsed_ms() < elapsed + 119)
+		result = FAIL;
+	return result;
+}
+
+#define WHEEL_TEST_ENTRIES 1000
+#define WHEEL_TEST_SPREAD 600
+static timer_entry_t wheel_entries[WHEEL_TEST_ENTRIES];
+static uint32_t wheel_delay[WHEEL_TEST_ENTRIES];
+static uint32_t wheel_fired_at[WHEEL_TEST_ENTRIES];
+static uint32_t wheel_fired;
+
+static void wheel_test_fire(void* data) {
+	wheel_fired_at[(uint32_t) data] = timer_elapsed_ms();
+	wheel_fired++;
+}
+
+/* Timer Wheel Test
+ *
+ * Adds a thousand timeouts, one of them a full wheel round out so it shares a
+ * slot with short ones, and checks none fires early and each tick only costs
+ * one interrupt
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Programs the PIT, enables interrupts while waiting (about 2.6 s)
+ * Coverage: timer_add, wheel ticks in timer_interrupt
+ * Files: timer.c
+ */
+int timer_wheel_test(){
+	TEST_HEADER;
+	timer_stats_t before = *timer_get_stats();
+	uint32_t start, i, ticks;
+	int result = PASS;
+
+	cli();
+	wheel_fired = 0;
+	start = timer_elapsed_ms();
+	for (i = 0; i < WHEEL_TEST_ENTRIES; i++) {
+		wheel_delay[i] = i ? 1 + (i * 7) % WHEEL_TEST_SPREAD : WHEEL_SLOTS * WHEEL_TICK_MS + 2 * WHEEL_TICK_MS;
+		wheel_entries[i].fn = wheel_test_fire;
+		wheel_entries[i].data = (void*) i;
+		timer_add(&wheel_entries[i], wheel_delay[i]);
+	}
+	sti();
+	while (wheel_fired < WHEEL_TEST_ENTRIES)
+		asm volatile ("hlt");
+
+	for (i = 0; i < WHEEL_TEST_ENTRIES; i++) {
+		if (wheel_entries[i].pending || wheel_fired_at[i] - start < wheel_delay[i] - 1)
+			result = FAIL;
+	}
+	ticks = timer_get_stats()->wheel_ticks - before.wheel_ticks;
+	if (ticks > wheel_delay[0] / WHEEL_TICK_MS + 2)
+		result = FAIL;
+	if (timer_get_stats()->interrupts - before.interrupts != ticks)
+		result = FAIL;
+	if (timer_get_stats()->timeouts - before.timeouts != WHEEL_TEST_ENTRIES)
+		result = FAIL;
+	return result;
+}
+
+#define CLOCK_TEST_MS 100
+#define CLOCK_TEST_SLACK_MS 5
+#define YEAR_2020 1577836800
+
+/* Clock Test
+ *
+ * Checks the TSC clock against a PIT deadline and the CMOS wall clock for sanity
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Programs the PIT, enables interrupts while waiting
+ * Coverage: clock_ns, clock_cycles_to_ns, clock_gettime, rtc_wall_clock
+ * Files: clock.c, drivers/pit.c, drivers/rtc.c
+ */
+int clock_test(){
+	TEST_HEADER;
+	timespec_t mono, wall;
+	uint64_t start, span;
+	int result = PASS;
+
+	if (clock_cycles_to_ns(clock_tsc_khz()) != NS_PER_MS || clock_cycles_to_ns(0) != 0)
+		result = FAIL;
+	if (clock_boot_time() < YEAR_2020)
+		result = FAIL;
+
+	// a PIT deadline measured on the TSC clock
+	cli();
+	start = clock_ns();
+	timer_arm(CLOCK_TEST_MS);
+	sti();
+	while (timer_armed())
+		asm volatile ("hlt");
+	span = clock_ns() - start;
+	if (span < (uint64_t) (CLOCK_TEST_MS - CLOCK_TEST_SLACK_MS) * NS_PER_MS ||
+		span > (uint64_t) (CLOCK_TEST_MS + CLOCK_TEST_SLACK_MS) * NS_PER_MS)
+		result = FAIL;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &mono) != 0 || clock_gettime(CLOCK_REALTIME, &wall) != 0)
+		result = FAIL;
+	if (mono.nsec >= NS_PER_SEC || wall.sec < clock_boot_time() + mono.sec)
+		result = FAIL;
+	if (clock_gettime(CLOCK_REALTIME + 1, &mono) != -1)
+		result = FAIL;
+	return result;
+}
+
+/* Vdso Test
+ *
+ * Checks the shared page is mapped user read-only at VDSO_ADDR, tracks the
+ * published task and that its scale factors agree with the kernel clock
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Overwrites the published task, put back afterwards
+ * Coverage: vdso_init, vdso_set_task
+ * Files: vdso.c
+ */
+int vdso_test(){
+	TEST_HEADER;
+	vdso_data_t* kernel_view = vdso_data();
+	volatile vdso_data_t* user_view = (volatile vdso_data_t*) VDSO_ADDR;
+	uint32_t pde = page_directory[VDSO_PD];
+	int32_t old_pid, old_term;
+	uint64_t cycles, lo, hi, ns;
+	int result = PASS;
+
+	if (kernel_view == NULL)
+		return FAIL;
+	if (!(pde & PRESENT) || !(pde & USER_SPACE) || (pde & WRITE_ENABLE))
+		return FAIL;
+	if (virtual_to_physical(VDSO_ADDR) != (uint32_t) kernel_view)
+		result = FAIL;
+
+	old_pid = kernel_view->pid;
+	old_term = kernel_view->term;
+	vdso_set_task(7, 2);
+	if (user_view->pid != 7 || user_view->term != 2)
+		result = FAIL;
+	vdso_set_task(old_pid, old_term);
+
+	// a second of TSC scaled the way ece391support.c does it
+	cycles = (uint64_t) user_view->tsc_khz * 1000;
+	lo = (uint64_t) (uint32_t) cycles * user_view->ns_mult;
+	hi = (uint64_t) (uint32_t) (cycles >> 32) * user_view->ns_mult;
+	ns = (hi << (32 - user_view->ns_shift)) + (lo >> user_view->ns_shift);
+	if (ns > NS_PER_SEC || ns < NS_PER_SEC - 1000)
+		result = FAIL;
+	if (user_view->boot_tsc != clock_boot_tsc() || user_view->boot_time != clock_boot_time())
+		result = FAIL;
+	return result;
+}
+
+/* Sysenter Test
+ *
+ * Checks the SYSENTER MSRs point at sysenter_entry on the kernel code segment,
+ * the user selectors SYSEXIT derives from it, and that SEP matches
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ * Coverage: SYSENTER setup in idt_init
+ * Files: idt.c, handlers.S
+ */
+int sysenter_test(){
+	TEST_HEADER;
+	int result = PASS;
+
+	if (sysenter_enabled() != ((cpuid_features() & CPUID_SEP) != 0))
+		result = FAIL;
+	if (!sysenter_enabled())
+		return result;
+	if (rdmsr(MSR_SYSENTER_CS) != KERNEL_CS || rdmsr(MSR_SYSENTER_EIP) != (uint32_t) sysenter_entry)
+		result = FAIL;
+	if (KERNEL_CS + 8 != KERNEL_DS || ((KERNEL_CS + 16) | 3) != USER_CS || ((KERNEL_CS + 24) | 3) != USER_DS)
+		result = FAIL;
+	return result;
+}
+
+/* Trace Test
+ *
+ * Runs the tracing hooks for a read and a halt as a scratch process and
+ * checks the ring, the histogram and the per pid counts
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Clears the trace, switches it off afterwards
+ * Coverage: trace_syscall_enter, trace_syscall_exit, trace_control
+ * Files: trace.c
+ */
+int trace_test(){
+	TEST_HEADER;
+	static trace_entry_t entries[4];
+	static trace_hist_t h;
+	static trace_task_t t[TRACE_PIDS];
+	int old_pid = pid, p, n, i, found = 0;
+	int result = PASS;
+
+	p = alloc_new_process();
+	if (p == -1)
+		return FAIL;
+	pid = p;
+	trace_task_start(p, (const uint8_t*) "tracetest");
+	trace_control(TRACE_ON, NULL, 0);
+	trace_syscall_enter(SYS_READ - 1, 1, 0x8049000, 1024);
+	trace_syscall_exit(1024);
+	trace_syscall_enter(SYS_HALT - 1, 7, 0, 0);
+	// halt never reaches the exit hook, a stray exit is ignored
+	trace_syscall_exit(-1);
+	trace_control(TRACE_OFF, NULL, 0);
+	pid = old_pid;
+	dealloc_process(p);
+
+	n = trace_control(TRACE_READ, entries, sizeof(entries));
+	if (n != 2 || entries[0].nr != SYS_READ || entries[0].args[2] != 1024 || entries[0].ret != 1024)
+		result = FAIL;
+	if (entries[1].nr != SYS_HALT || entries[1].ret != 7 || entries[1].seq != 1 || entries[1].pid != p)
+		result = FAIL;
+	if (trace_control(TRACE_HIST, &h, sizeof(h)) != 0 || h.calls[SYS_READ - 1] != 1 || h.calls[SYS_HALT - 1] != 1)
+		result = FAIL;
+	n = trace_control(TRACE_TASKS, t, sizeof(t));
+	for (i = 0; i < n; i++) {
+		if (t[i].pid == p && t[i].calls[SYS_READ - 1] == 1 && strncmp((int8_t*) t[i].cmd, "tracetest", TRACE_CMD_LEN) == 0)
+			found = 1;
+	}
+	if (!found || trace_control(TRACE_HIST, &h, sizeof(h) - 1) != -1)
+		result = FAIL;
+	return result;
+}
+
+static fd_ops_t test_pipe_read_end = { pipe_read, pipe_bad_write, pipe_close_read };
+static fd_ops_t test_pipe_write_end = { pipe_bad_read, pipe_write, pipe_close_write };
+
+/*
+ * open_test_pipe
+ * DESCRIPTION: opens both ends of a new pipe in a scratch process by hand
+ * INPUTS: pcb: scratch process, rd: read end fd, wr: write end fd
+ * SIDE EFFECTS: allocates a pipe
+ * RETURN VALUE: none
+ */
+static void open_test_pipe(pcb_t* pcb, int rd, int wr){
+	pcb->fd_array[rd].table_pointer = test_pipe_read_end;
+	pcb->fd_array[wr].table_pointer = test_pipe_write_end;
+	pcb->fd_array[rd].pipe = pipe_create();
+	pcb->fd_array[wr].pipe = pcb->fd_array[rd].pipe;
+	pcb->fd_array[rd].flags = FD_USED;
+	pcb->fd_array[wr].flags = FD_USED;
+}
+
+/* Ring Test
+ *
+ * Registers a four entry ring as a scratch process, queues a nop, a read of a
+ * closed fd and an unknown opcode, and checks the completions, then fills the
+ * completion queue and checks ring_enter stops. Last, reads and writes on an
+ * open pipe with a kernel buffer have to fail without touching the pipe
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ * Coverage: ring_setup, ring_enter
+ * Files: ring.c
+ */
+int ring_test(){
+	TEST_HEADER;
+	static io_ring_t ring;
+	int old_pid = pid, p, i;
+	uint8_t buf[4];
+	int result = PASS;
+
+	p = alloc_new_process();
+	if (p == -1)
+		return FAIL;
+	pid = p;
+	if (ring_setup(&ring, 3) != -1 || ring_setup(&ring, RING_MAX_ENTRIES * 2) != -1 || ring_setup(&ring, 4) != 0)
+		result = FAIL;
+	ring.sqes[0].op = RING_OP_NOP;
+	ring.sqes[0].user_data = 10;
+	ring.sqes[1].op = RING_OP_READ;
+	ring.sqes[1].fd = MAX_FD;
+	ring.sqes[1].buf = (uint32_t) &ring;
+	ring.sqes[1].user_data = 11;
+	ring.sqes[2].op = 0xFF;
+	ring.sqes[2].user_data = 12;
+	ring.sq_tail = 3;
+	if (ring_enter(2) != 2 || ring_enter(8) != 1 || ring.sq_head != 3 || ring.cq_tail != 3)
+		result = FAIL;
+	if (ring.cqes[0].user_data != 10 || ring.cqes[0].res != 0 || ring.cqes[1].user_data != 11 || ring.cqes[1].res != -1)
+		result = FAIL;
+	if (ring.cqes[2].user_data != 12 || ring.cqes[2].res != -1)
+		result = FAIL;
+
+	// one completion slot left, then none
+	for (i = 3; i < 6; i++)
+		ring.sqes[i & 3].op = RING_OP_NOP;
+	ring.sq_tail = 6;
+	if (ring_enter(3) != 1 || ring.sq_head != 4 || ring_enter(3) != 0)
+		result = FAIL;
+	ring.cq_head = 4;
+	if (ring_enter(3) != 2 || ring.cq_tail != 6)
+		result = FAIL;
+
+	// the fds are open, only the buffers are wrong
+	open_test_pipe(get_pcb(p), 2, 3);
+	if (sys_write(3, "ab", 2) != 2)
+		result = FAIL;
+	ring.cq_head = 6;
+	for (i = 6; i < 8; i++) {
+		ring.sqes[i & 3].op = (i == 6) ? RING_OP_READ : RING_OP_WRITE;
+		ring.sqes[i & 3].fd = (i == 6) ? 2 : 3;
+		ring.sqes[i & 3].buf = (uint32_t) &ring;
+		ring.sqes[i & 3].nbytes = 2;
+	}
+	ring.sq_tail = 8;
+	if (ring_enter(2) != 2 || ring.cqes[6 & 3].res != -1 || ring.cqes[7 & 3].res != -1)
+		result = FAIL;
+	if (sys_read(2, buf, sizeof(buf)) != 2 || strncmp((int8_t*) buf, "ab", 2) != 0)
+		result = FAIL;
+	sys_close(2);
+	sys_close(3);
+	pid = old_pid;
+	dealloc_process(p);
+	return result;
+}
+
+/* Vectored IO Test
+ *
+ * Prints a buffer with a NUL in it in one go, and checks readv and writev
+ * turn away closed descriptors and vectors outside the program window
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Prints a line
+ * Coverage: putbuf_colourised, sys_readv, sys_writev
+ * Files: lib.c, syscalls.c
+ */
+int iov_test(){
+	TEST_HEADER;
+	static iovec_t iov[IOV_MAX + 1];
+	int old_pid = pid, p;
+	int result = PASS;
+
+	if (putbuf_colourised((const uint8_t*) "iov\0 test\n", 10, LT_GREEN) != 9)
+		result = FAIL;
+
+	p = alloc_new_process();
+	if (p == -1)
+		return FAIL;
+	pid = p;
+	iov[0].base = (void*) PROGRAM_VIRT_START;
+	iov[0].len = 1;
+	// nothing is open in a scratch process, and iov itself is kernel memory
+	if (sys_writev(1, iov, 1) != -1 || sys_readv(MAX_FD + 1, iov, 1) != -1)
+		result = FAIL;
+	get_pcb(p)->fd_array[1].flags |= FD_USED;
+	if (sys_writev(1, iov, 1) != -1 || sys_writev(1, iov, IOV_MAX + 1) != -1 || sys_writev(1, iov, 0) != -1)
+		result = FAIL;
+	get_pcb(p)->fd_array[1].flags &= ~FD_USED;
+	pid = old_pid;
+	dealloc_process(p);
+	return result;
+}
+
+static int32_t iov_last_write;
+
+/*
+ * iov_count_write
+ * DESCRIPTION: write handler that only records how much writev handed it
+ * INPUTS: fd: ignored, buf: ignored, nbytes: bytes passed
+ * SIDE EFFECTS: sets iov_last_write
+ * RETURN VALUE: nbytes
+ */
+static int32_t iov_count_write(uint32_t fd, const void* buf, int32_t nbytes){
+	iov_last_write = nbytes;
+	return nbytes;
+}
+
+/* Vectored IO Data Test
+ *
+ * Puts an iovec array and its buffers in a scratch process' window and moves
+ * data through a pipe with writev and readv, including a read that ends
+ * partway through the second piece, then checks vectors longer than
+ * IOV_MAX_BYTES are cut short for a file read and a write
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: Switches to the scratch process' PD and back to the kernel's
+ * Coverage: sys_readv, sys_writev
+ * Files: syscalls.c
+ */
+int iov_data_test(){
+	TEST_HEADER;
+	static fd_ops_t count_ops = { NULL, iov_count_write, NULL };
+	iovec_t* iov = (iovec_t*) IOV_TEST_WINDOW;
+	uint8_t* a = (uint8_t*) (IOV_TEST_WINDOW + 0x100);
+	uint8_t* b = (uint8_t*) (IOV_TEST_WINDOW + 0x200);
+	uint8_t* big = (uint8_t*) (IOV_TEST_WINDOW + FOUR_KB);
+	uint8_t buf[8];
+	int old_pid = pid, p, fd;
+	pcb_t* pcb;
+	dentry_t dentry;
+	int result = PASS;
+
+	p = alloc_new_process();
+	if (p == -1)
+		return FAIL;
+	pcb = get_pcb(p);
+	pcb->image = NULL; // no program, only the stack part of the window pages in
+	if (context_switch_paging(p) == -1){
+		dealloc_process(p);
+		return FAIL;
+	}
+	pid = p;
+	open_test_pipe(pcb, 2, 3);
+
+	// gather two pieces into one pipe write
+	memcpy(a, "abc", 3);
+	memcpy(b, "defg", 4);
+	iov[0].base = a;
+	iov[0].len = 3;
+	iov[1].base = b;
+	iov[1].len = 4;
+	if (sys_writev(3, iov, 2) != 7 || sys_read(2, buf, sizeof(buf)) != 7 || strncmp((int8_t*) buf, "abcdefg", 7) != 0)
+		result = FAIL;
+
+	// five bytes fill the first piece and half the second
+	memset(a, '#', 3);
+	memset(b, '#', 4);
+	if (sys_write(3, "hello", 5) != 5 || sys_readv(2, iov, 2) != 5)
+		result = FAIL;
+	if (strncmp((int8_t*) a, "hel", 3) != 0 || strncmp((int8_t*) b, "lo##", 4) != 0)
+		result = FAIL;
+	sys_close(2);
+	sys_close(3);
+
+	// 0x1800 bytes asked for, one bounce buffer's worth comes back
+	memset(big, 0xA5, 0x1800);
+	iov[0].base = big;
+	iov[0].len = 0x800;
+	iov[1].base = big + 0x800;
+	iov[1].len = 0x1000;
+	fd = sys_open((uint8_t*) "shell");
+	if (fd == -1 || read_dentry_by_name((uint8_t*) "shell", &dentry) == -1)
+		result = FAIL;
+	else if (sys_readv(fd, iov, 2) != IOV_MAX_BYTES || read_data(dentry.inode_num, 0, read_fast, IOV_MAX_BYTES) != IOV_MAX_BYTES)
+		result = FAIL;
+	else if (!bytes_equal(big, read_fast, IOV_MAX_BYTES) || big[IOV_MAX_BYTES] != 0xA5 || big[0x17FF] != 0xA5)
+		result = FAIL;
+	if (fd != -1)
+		sys_close(fd);
+
+	// and a write of the same vector hands over the same amount
+	pcb->fd_array[4].table_pointer = count_ops;
+	pcb->fd_array[4].flags = FD_USED;
+	if (sys_writev(4, iov, 2) != IOV_MAX_BYTES || iov_last_write != IOV_MAX_BYTES)
+		result = FAIL;
+	pcb->fd_array[4].flags = 0;
+
+	context_switch_paging(KERNEL_PD);
+	pid = old_pid;
+	dealloc_process(p);
+	return result;
+}
+
+/* Pipe Test
+ *
+ * Opens both ends of a pipe in a scratch process, passes data through it
+ * (once across the wrap), and checks end of file after the last writer
+ * closes and -1 for a write with no reader left
+ * Inputs: None
+ * Outputs: PASS or FAIL
+ * Side Effects: None
+ * Coverage: pipe_create, pipe_read, pipe_write, pipe_dup, pipe close
+ * Files: pipe.c
+ */
+int pipe_test(){
+	TEST_HEADER;
+	static uint8_t big[PIPE_SIZE];
+	uint8_t buf[16];
+	int old_pid = pid, p;
+	pcb_t* pcb;
+	int result = PASS;
+
+	p = alloc_new_process();
+	if (p == -1)
+		return FAIL;
+	pid = p;
+	pcb = get_pcb(p);
+	memset(pcb->fd_array, 0, sizeof(pcb->fd_array));
+	open_test_pipe(pcb, 2, 3);
+
+	if (sys_write(3, "hello", 5) != 5 || sys_read(2, buf, sizeof(buf)) != 5 || strncmp((int8_t*) buf, "hello", 5) != 0)
+		result = FAIL;
+	if (sys_write(2, "x", 1) != -1 || sys_read(3, buf, 1) != -1)
+		result = FAIL;
+	// fill up to just before the end, then a write that wraps
+	if (sys_write(3, big, PIPE_SIZE - 7) != PIPE_SIZE - 7 || sys_read(2, big, PIPE_SIZE) != PIPE_SIZE - 7)
+		result = FAIL;
+	if (sys_write(3, "wrapped", 7) != 7 || sys_write(3, "!", 1) != 1 || sys_read(2, buf, sizeof(buf)) != 8 || strncmp((int8_t*) buf, "wrapped!", 8) != 0)
+		result = FAIL;
+
+	// a second writer, the pipe only ends when both are gone
+	pcb->fd_array[4] = pcb->fd_array[3];
+	pipe_dup(&(pcb->fd_array[4]));
+	sys_close(3);
+	if (sys_write(4, "z", 1) != 1 || sys_read(2, buf, sizeof(buf)) != 1)
+		result = FAIL;
+	sys_close(4);
+	if (sys_read(2, buf, sizeof(buf)) != 0)
+		result = FAIL;
+	sys_close(2);
+
+	// nobody left to read
+	open_test_pipe(pcb, 2, 3);
+	sys_close(2);
+	if (sys_write(3, "x", 1) != -1)
+		result = FAIL;
+	sys_close(3);
+
+	pid = old_pid;
+	dealloc_process(p);
+	return result;
+}
 
 /* Test suite entry point */
 void launch_tests(){
@@ -521,6 +1578,25 @@ void launch_tests(){
 	// TEST_OUTPUT("systemcall test", syscall_execute());
 	// TEST_OUTPUT("virtual_to_physical_test", virtual_to_physical_test());
 	// TEST_OUTPUT("page_alloc_context_switch_test", page_alloc_context_switch_test());
+	// TEST_OUTPUT("dentry_lookup_test", dentry_lookup_test());
+	// TEST_OUTPUT("image_cache_test", image_cache_test());
+	// TEST_OUTPUT("frame_alloc_test", frame_alloc_test());
+	// TEST_OUTPUT("kmalloc_test", kmalloc_test());
+	// TEST_OUTPUT("tlb_test", tlb_test());
+	// TEST_OUTPUT("context_switch_benchmark", context_switch_benchmark());
+	// TEST_OUTPUT("switch_to_benchmark", switch_to_benchmark());
+	// TEST_OUTPUT("timer_test", timer_test());
+	// TEST_OUTPUT("timer_wheel_test", timer_wheel_test());
+	// TEST_OUTPUT("clock_test", clock_test());
+	// TEST_OUTPUT("vdso_test", vdso_test());
+	// TEST_OUTPUT("sysenter_test", sysenter_test());
+	// TEST_OUTPUT("trace_test", trace_test());
+	// TEST_OUTPUT("ring_test", ring_test());
+	// TEST_OUTPUT("iov_test", iov_test());
+	// TEST_OUTPUT("pipe_test", pipe_test());
+	// TEST_OUTPUT("extent_read_test", extent_read_test());
+	// TEST_OUTPUT("extent_read_benchmark", extent_read_benchmark());
+	// TEST_OUTPUT("iov_data_test", iov_data_test());
 	// hold at end
 	// TEST_OUTPUT("terminal_run_test", terminal_run_test());
 }
@@ -0,0 +1,320 @@
+#include "timer.h"
+#include "lib.h"
+#include "i8259.h"
+#include "scheduling.h"
+#include "drivers/pit.h"
+
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_TICK_CYCLES (WHEEL_TICK_MS * PIT_CYCLES_PER_MS)
+
+static uint32_t quantum_ms = DEFAULT_QUANTUM_MS;
+// PIT cycles counted by finished shots, deadlines are kept on this clock
+static uint64_t now_cycles = 0;
+// PIT cycles in the one-shot the PIT is counting now, 0 when it is stopped
+static uint32_t shot_cycles = 0;
+// scheduler deadline
+static int armed = 0;
+static uint64_t deadline = 0;
+// timeout wheel, the PIT keeps ticking it only while it holds entries
+static timer_entry_t* wheel[WHEEL_SLOTS];
+static uint32_t wheel_count = 0;
+static uint32_t wheel_now = 0;
+static uint64_t wheel_deadline = 0;
+// cycles counted, folded into elapsed_ms as whole ms
+static uint32_t elapsed_cycles = 0;
+static uint32_t elapsed_ms = 0;
+static timer_stats_t stats;
+
+/*
+ * timer_shot_ran
+ * DESCRIPTION: How much of the current shot has run. A count above the shot
+ * means the PIT wrapped after firing, with the interrupt still pending
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: PIT cycles
+ */
+static uint32_t timer_shot_ran() {
+	uint16_t left;
+
+	if (shot_cycles == 0)
+		return 0;
+	left = pit_read_count();
+	return (left <= shot_cycles) ? shot_cycles - left : shot_cycles;
+}
+
+/*
+ * timer_account
+ * DESCRIPTION: Moves the part of the current shot that has run onto now_cycles
+ * INPUTS: fired: 1 if the shot ran out, 0 if it is being cut short
+ * SIDE EFFECTS: advances now_cycles and elapsed time
+ * RETURN VALUE: none
+ */
+static void timer_account(int fired) {
+	uint32_t ran = fired ? shot_cycles : timer_shot_ran();
+
+	now_cycles += ran;
+	elapsed_cycles += ran;
+	elapsed_ms += elapsed_cycles / PIT_CYCLES_PER_MS;
+	elapsed_cycles %= PIT_CYCLES_PER_MS;
+	shot_cycles = 0;
+}
+
+/*
+ * timer_program
+ * DESCRIPTION: Starts a shot for the nearer of the scheduler deadline and the
+ * next wheel tick, or stops the PIT if neither is needed. The PIT counts at
+ * most PIT_MAX_COUNT cycles (about 55 ms) per shot, longer waits take several
+ * INPUTS: none
+ * SIDE EFFECTS: programs the PIT, call after timer_account
+ * RETURN VALUE: none
+ */
+static void timer_program() {
+	uint64_t next;
+
+	if (armed && (wheel_count == 0 || deadline < wheel_deadline))
+		next = deadline;
+	else if (wheel_count > 0)
+		next = wheel_deadline;
+	else {
+		pit_stop();
+		shot_cycles = 0;
+		return;
+	}
+
+	if (next <= now_cycles)
+		shot_cycles = 1;
+	else if (next - now_cycles > PIT_MAX_COUNT)
+		shot_cycles = PIT_MAX_COUNT;
+	else
+		shot_cycles = (uint32_t) (next - now_cycles);
+	pit_oneshot((uint16_t) shot_cycles);
+}
+
+/*
+ * timer_init
+ * DESCRIPTION: Stops the PIT and enables its IRQ, deadlines are armed on demand
+ * INPUTS: none
+ * SIDE EFFECTS: enables IRQ for PIT
+ * RETURN VALUE: none
+ */
+void timer_init() {
+	pit_stop();
+	armed = 0;
+	enable_irq(PIT_IRQ);
+}
+
+/*
+ * timer_arm
+ * DESCRIPTION: Interrupts once, ms from now, replacing any armed deadline
+ * INPUTS: ms: delay, at least 1
+ * SIDE EFFECTS: programs the PIT
+ * RETURN VALUE: none
+ */
+void timer_arm(uint32_t ms) {
+	uint32_t flags;
+
+	if (ms == 0)
+		ms = 1;
+	if (ms > MAX_QUANTUM_MS * SCHED_MAX_QUANTA)
+		ms = MAX_QUANTUM_MS * SCHED_MAX_QUANTA;
+	cli_and_save(flags);
+	timer_account(0);
+	deadline = now_cycles + ms * PIT_CYCLES_PER_MS;
+	armed = 1;
+	timer_program();
+	stats.arms++;
+	restore_flags(flags);
+}
+
+/*
+ * timer_disarm
+ * DESCRIPTION: Cancels the armed deadline, the PIT stops unless timeouts are pending
+ * INPUTS: none
+ * SIDE EFFECTS: may stop the PIT
+ * RETURN VALUE: none
+ */
+void timer_disarm() {
+	uint32_t flags;
+
+	cli_and_save(flags);
+	if (armed) {
+		timer_account(0);
+		armed = 0;
+		timer_program();
+	}
+	stats.disarms++;
+	restore_flags(flags);
+}
+
+/*
+ * timer_armed
+ * DESCRIPTION: Tells whether a deadline is armed
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 1 if armed, 0 if not
+ */
+int timer_armed() {
+	return armed;
+}
+
+/*
+ * timer_remaining_ms
+ * DESCRIPTION: Time left before the armed deadline
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: ms, 0 if nothing is armed
+ */
+uint32_t timer_remaining_ms() {
+	uint32_t flags, left = 0;
+	uint64_t now;
+
+	cli_and_save(flags);
+	now = now_cycles + timer_shot_ran();
+	if (armed && deadline > now)
+		left = (uint32_t) (deadline - now) / PIT_CYCLES_PER_MS;
+	restore_flags(flags);
+	return left;
+}
+
+/*
+ * timer_elapsed_ms
+ * DESCRIPTION: Time the PIT has been counting. The timer is off while the CPU
+ * is idle or only one task is runnable and nothing is sleeping, so this is
+ * roughly time spent contended
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: ms
+ */
+uint32_t timer_elapsed_ms() {
+	return elapsed_ms;
+}
+
+/*
+ * timer_get_quantum
+ * DESCRIPTION: Base scheduling quantum
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: ms
+ */
+uint32_t timer_get_quantum() {
+	return quantum_ms;
+}
+
+/*
+ * timer_set_quantum
+ * DESCRIPTION: Changes the base scheduling quantum, takes effect at the next deadline
+ * INPUTS: ms: 1 to MAX_QUANTUM_MS
+ * SIDE EFFECTS: none
+ * RETURN VALUE: 0 on success, -1 if out of range
+ */
+int timer_set_quantum(uint32_t ms) {
+	if (ms == 0 || ms > MAX_QUANTUM_MS)
+		return -1;
+	quantum_ms = ms;
+	return 0;
+}
+
+/*
+ * timer_add
+ * DESCRIPTION: Hashes a timeout into the wheel slot of the tick it expires on,
+ * so adding one is O(1) however many are pending. While the wheel is ticking
+ * the current tick is partly gone, so one more tick is waited to never fire early
+ * INPUTS: entry: timeout with fn and data set, not already pending
+ * ms: delay, rounded up to whole ticks, at most MAX_TIMEOUT_MS
+ * SIDE EFFECTS: starts the wheel ticking if it was empty
+ * RETURN VALUE: none
+ */
+void timer_add(timer_entry_t* entry, uint32_t ms) {
+	uint32_t flags, ticks;
+
+	if (ms > MAX_TIMEOUT_MS)
+		ms = MAX_TIMEOUT_MS;
+	ticks = (ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+	if (ticks == 0)
+		ticks = 1;
+
+	cli_and_save(flags);
+	timer_account(0);
+	if (wheel_count == 0)
+		wheel_deadline = now_cycles + WHEEL_TICK_CYCLES;
+	else
+		ticks++;
+	entry->expires = wheel_now + ticks;
+	entry->pending = 1;
+	entry->next = wheel[entry->expires & WHEEL_MASK];
+	wheel[entry->expires & WHEEL_MASK] = entry;
+	wheel_count++;
+	timer_program();
+	restore_flags(flags);
+}
+
+/*
+ * timer_wheel_tick
+ * DESCRIPTION: Advances the wheel one tick and fires the entries in the new
+ * slot that are due this round, ones for a later round stay. Only one slot is
+ * looked at, so a tick costs the same however many timeouts are pending
+ * INPUTS: none
+ * SIDE EFFECTS: calls timeout callbacks, which may wake tasks
+ * RETURN VALUE: none
+ */
+static void timer_wheel_tick() {
+	timer_entry_t** link;
+	timer_entry_t* entry;
+
+	wheel_now++;
+	stats.wheel_ticks++;
+	link = &wheel[wheel_now & WHEEL_MASK];
+	while ((entry = *link) != NULL) {
+		if ((int32_t) (entry->expires - wheel_now) > 0) {
+			link = &entry->next;
+			continue;
+		}
+		*link = entry->next;
+		entry->next = NULL;
+		entry->pending = 0;
+		wheel_count--;
+		stats.timeouts++;
+		entry->fn(entry->data);
+	}
+}
+
+/*
+ * timer_interrupt
+ * DESCRIPTION: PIT one-shot ran out. Runs the wheel ticks that are due, then
+ * hands an expired deadline to the scheduler. A shot that only covered part of
+ * a long wait just starts the next one
+ * INPUTS: none
+ * SIDE EFFECTS: may wake tasks and switch tasks
+ * RETURN VALUE: none
+ */
+void timer_interrupt() {
+	stats.interrupts++;
+	if (shot_cycles == 0)
+		return;
+	timer_account(1);
+
+	while (wheel_count > 0 && now_cycles >= wheel_deadline) {
+		wheel_deadline += WHEEL_TICK_CYCLES;
+		timer_wheel_tick();
+	}
+
+	if (armed && now_cycles >= deadline) {
+		armed = 0;
+		stats.expiries++;
+		timer_program();
+		context_switch();
+		return;
+	}
+	timer_program();
+}
+
+/*
+ * timer_get_stats
+ * DESCRIPTION: Interrupt, deadline and timeout counters
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: the counters
+ */
+timer_stats_t* timer_get_stats() {
+	return &stats;
+}
@@ -0,0 +1,63 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "types.h"
+
+#define DEFAULT_QUANTUM_MS 28 // the old 35 Hz tick
+#define MAX_QUANTUM_MS 1000
+#define PIT_CYCLES_PER_MS 1193 // 1193182 Hz
+
+// timeout wheel, a slot per tick, longer timeouts wrap around and wait their round
+#define WHEEL_TICK_MS 10
+#define WHEEL_SLOTS 256 // power of two
+#define MAX_TIMEOUT_MS 0x10000000
+
+typedef struct timer_stats {
+	uint32_t interrupts; // PIT interrupts, including the ones continuing a long deadline
+	uint32_t expiries;   // deadlines that reached the scheduler
+	uint32_t arms;
+	uint32_t disarms;    // times no deadline was needed (idle or one runnable task)
+	uint32_t wheel_ticks;
+	uint32_t timeouts;   // timeout callbacks run
+} timer_stats_t;
+
+// a pending timeout, owned by the caller until it fires
+typedef struct timer_entry {
+	struct timer_entry* next; // next entry in the same wheel slot
+	uint32_t expires;         // wheel tick it fires on
+	int pending;              // 1 from timer_add until fn is called
+	void (*fn)(void* data);   // called from the PIT interrupt with interrupts off
+	void* data;
+} timer_entry_t;
+
+// program the PIT for one-shot deadlines, nothing is armed until timer_arm
+void timer_init();
+
+// interrupt once, ms from now, replacing any armed deadline
+void timer_arm(uint32_t ms);
+
+// cancel the armed deadline
+void timer_disarm();
+
+// 1 while a deadline is armed
+int timer_armed();
+
+// ms left before the armed deadline, 0 if none is armed
+uint32_t timer_remaining_ms();
+
+// ms the PIT has been counting, time with nothing armed or pending is not counted
+uint32_t timer_elapsed_ms();
+
+// base scheduling quantum, every MLFQ level runs for a multiple of it
+uint32_t timer_get_quantum();
+int timer_set_quantum(uint32_t ms);
+
+// call entry->fn(entry->data) at least ms from now
+void timer_add(timer_entry_t* entry, uint32_t ms);
+
+// called by the PIT driver on every interrupt
+void timer_interrupt();
+
+timer_stats_t* timer_get_stats();
+
+#endif // TIMER_H
@@ -0,0 +1,77 @@
+#include "tlb.h"
+
+#define ACCESSED_DIRTY 0x60 // set by the cpu, not part of the translation
+
+static tlb_stats_t tlb_stats = { 0 };
+
+/*
+ * tlb_set_entry
+ * DESCRIPTION: updates a PDE or PTE. When the value is unchanged (apart from the
+ * accessed and dirty bits) the TLB cannot hold anything stale, so the
+ * invalidation is skipped
+ * INPUTS: entry: paging entry, value: new entry, vaddr: an address it maps
+ * SIDE EFFECTS: writes the entry, may invlpg
+ * RETURN VALUE: none
+ */
+void tlb_set_entry(uint32_t* entry, uint32_t value, uint32_t vaddr) {
+	if ((*entry & ~ACCESSED_DIRTY) == (value & ~ACCESSED_DIRTY)) {
+		tlb_stats.skipped++;
+		return;
+	}
+	*entry = value;
+	tlb_flush_page(vaddr);
+}
+
+/*
+ * tlb_flush_page
+ * DESCRIPTION: invalidates the translation (and cached directory entry) of one page
+ * INPUTS: vaddr: address in the page
+ * SIDE EFFECTS: invlpg
+ * RETURN VALUE: none
+ */
+void tlb_flush_page(uint32_t vaddr) {
+	asm volatile("invlpg (%0)" :: "r"(vaddr) : "memory");
+	tlb_stats.page_flushes++;
+}
+
+/*
+ * tlb_flush_all
+ * DESCRIPTION: reloads cr3 with the current directory, for changes too wide to
+ * invalidate page by page
+ * INPUTS: none
+ * SIDE EFFECTS: flushes every non global TLB entry
+ * RETURN VALUE: none
+ */
+void tlb_flush_all() {
+	asm volatile (
+		"movl %%cr3, %%eax\n\t"
+		"movl %%eax, %%cr3\n\t"
+		:
+		:
+		: "eax", "memory"
+		);
+	tlb_stats.full_flushes++;
+}
+
+/*
+ * tlb_load_cr3
+ * DESCRIPTION: switches page directory
+ * INPUTS: page_dir: directory to load
+ * SIDE EFFECTS: writes cr3, flushing every non global TLB entry
+ * RETURN VALUE: none
+ */
+void tlb_load_cr3(uint32_t* page_dir) {
+	asm volatile("movl %0, %%cr3" :: "r"(page_dir) : "memory");
+	tlb_stats.cr3_loads++;
+}
+
+/*
+ * tlb_get_stats
+ * DESCRIPTION: copies the invalidation counters
+ * INPUTS: stats: where to copy them
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+void tlb_get_stats(tlb_stats_t* stats) {
+	*stats = tlb_stats;
+}
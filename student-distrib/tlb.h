@@ -0,0 +1,29 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include "types.h"
+
+// how often each kind of invalidation happened
+typedef struct tlb_stats {
+	uint32_t full_flushes;  // cr3 rewritten with the same directory
+	uint32_t page_flushes;  // single invlpg
+	uint32_t skipped;       // entry already held the new value
+	uint32_t cr3_loads;     // switches to another page directory
+} tlb_stats_t;
+
+// write a paging entry mapping vaddr, invalidating only that page if it changed
+void tlb_set_entry(uint32_t* entry, uint32_t value, uint32_t vaddr);
+
+// drop the cached translation of one page
+void tlb_flush_page(uint32_t vaddr);
+
+// drop every non global translation
+void tlb_flush_all();
+
+// switch to another page directory
+void tlb_load_cr3(uint32_t* page_dir);
+
+// copy the counters out
+void tlb_get_stats(tlb_stats_t* stats);
+
+#endif // TLB_H
@@ -0,0 +1,207 @@
+#include "trace.h"
+#include "lib.h"
+#include "pcb.h"
+#include "x86_desc.h"
+#include "syscalls.h"
+
+int trace_enabled = 0;
+static trace_entry_t ring[TRACE_RING];
+static uint32_t ring_seq = 0;
+static trace_hist_t hist;
+static trace_task_t tasks[TRACE_PIDS];
+
+/*
+ * trace_bucket
+ * DESCRIPTION: Log2 latency bucket
+ * INPUTS: cycles: call latency
+ * SIDE EFFECTS: none
+ * RETURN VALUE: index of the highest set bit, the last bucket for anything bigger
+ */
+static uint32_t trace_bucket(uint64_t cycles) {
+	uint32_t bit;
+
+	if (cycles >> 32)
+		return TRACE_BUCKETS - 1;
+	if ((uint32_t) cycles == 0)
+		return 0;
+	asm ("bsrl %1, %0" : "=r"(bit) : "rm"((uint32_t) cycles));
+	return bit;
+}
+
+/*
+ * trace_record
+ * DESCRIPTION: Adds a finished call to the ring, its histogram and its pid's counters
+ * INPUTS: pcb: caller, with the call it made, ret: return value, cycles: latency
+ * SIDE EFFECTS: overwrites the oldest ring entry
+ * RETURN VALUE: none
+ */
+static void trace_record(pcb_t* pcb, int32_t ret, uint64_t cycles) {
+	uint32_t nr = pcb->trace_nr - 1, flags;
+	trace_entry_t* entry;
+
+	cli_and_save(flags);
+	entry = &ring[ring_seq & (TRACE_RING - 1)];
+	entry->seq = ring_seq++;
+	entry->pid = pcb->pid;
+	entry->nr = pcb->trace_nr;
+	memcpy(entry->args, pcb->trace_args, sizeof(entry->args));
+	entry->ret = ret;
+	entry->cycles = (cycles >> 32) ? 0xFFFFFFFF : (uint32_t) cycles;
+
+	hist.calls[nr]++;
+	hist.cycles[nr] += cycles;
+	hist.buckets[nr][trace_bucket(cycles)]++;
+	if (pcb->pid >= 0 && pcb->pid < TRACE_PIDS) {
+		tasks[pcb->pid].calls[nr]++;
+		tasks[pcb->pid].cycles[nr] += cycles;
+	}
+	pcb->trace_nr = 0;
+	restore_flags(flags);
+}
+
+/*
+ * trace_syscall_enter
+ * DESCRIPTION: Notes the call and its start time in the caller's PCB, the call
+ * may block and other tasks make calls before it returns. Halt does not
+ * return to its caller, so it is recorded here. A call made before pid has a
+ * task stack (during boot) is not traced
+ * INPUTS: nr: jump table index (number - 1), a, b, c: EBX, ECX, EDX
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+void trace_syscall_enter(uint32_t nr, uint32_t a, uint32_t b, uint32_t c) {
+	pcb_t* pcb;
+
+	if (get_task_stack(pid) == NULL)
+		return;
+	pcb = get_pcb(pid);
+	pcb->trace_nr = nr + 1;
+	pcb->trace_args[0] = a;
+	pcb->trace_args[1] = b;
+	pcb->trace_args[2] = c;
+	pcb->trace_start = rdtsc();
+	if (pcb->trace_nr == SYS_HALT)
+		trace_record(pcb, (uint8_t) a, 0);
+}
+
+/*
+ * trace_syscall_exit
+ * DESCRIPTION: Records the current task's call as finished
+ * INPUTS: ret: its return value
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+void trace_syscall_exit(int32_t ret) {
+	pcb_t* pcb;
+
+	if (get_task_stack(pid) == NULL)
+		return;
+	pcb = get_pcb(pid);
+	// tracing was switched on during the call
+	if (pcb->trace_nr == 0)
+		return;
+	trace_record(pcb, ret, rdtsc() - pcb->trace_start);
+}
+
+/*
+ * trace_task_start
+ * DESCRIPTION: Starts a pid's counters over for the program it now runs
+ * INPUTS: pid: the process, cmd: program name
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+void trace_task_start(int32_t pid, const uint8_t* cmd) {
+	trace_task_t* task;
+
+	if (pid < 0 || pid >= TRACE_PIDS)
+		return;
+	task = &tasks[pid];
+	memset(task, 0, sizeof(trace_task_t));
+	task->pid = pid;
+	strncpy((int8_t*) task->cmd, (const int8_t*) cmd, TRACE_CMD_LEN - 1);
+}
+
+/*
+ * trace_reset
+ * DESCRIPTION: Clears the ring, the histograms and the per pid counts, the
+ * program names stay. Calls in flight were not noted and are not recorded
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: none
+ */
+static void trace_reset() {
+	int i;
+
+	memset(ring, 0, sizeof(ring));
+	ring_seq = 0;
+	memset(&hist, 0, sizeof(hist));
+	for (i = 0; i < TRACE_PIDS; i++) {
+		memset(tasks[i].calls, 0, sizeof(tasks[i].calls));
+		memset(tasks[i].cycles, 0, sizeof(tasks[i].cycles));
+		if (get_task_stack(i) != NULL)
+			get_pcb(i)->trace_nr = 0;
+	}
+}
+
+/*
+ * trace_control
+ * DESCRIPTION: Switches tracing on or off and copies out what it recorded
+ * INPUTS: cmd: TRACE_*, buf: kernel address of the caller's buffer, nbytes: its size
+ * SIDE EFFECTS: TRACE_ON clears everything recorded so far
+ * RETURN VALUE: TRACE_READ and TRACE_TASKS: entries copied, 0 for the
+ * others, -1 for an unknown command or a buffer too small for a trace_hist_t
+ */
+int32_t trace_control(int32_t cmd, void* buf, int32_t nbytes) {
+	uint32_t flags, max, count, first, i, nr;
+	trace_entry_t* entries = (trace_entry_t*) buf;
+	trace_task_t* out = (trace_task_t*) buf;
+
+	switch (cmd) {
+	case TRACE_OFF:
+		trace_enabled = 0;
+		return 0;
+
+	case TRACE_ON:
+		cli_and_save(flags);
+		trace_reset();
+		trace_enabled = 1;
+		restore_flags(flags);
+		return 0;
+
+	case TRACE_READ:
+		max = nbytes / sizeof(trace_entry_t);
+		cli_and_save(flags);
+		count = (ring_seq < TRACE_RING) ? ring_seq : TRACE_RING;
+		if (count > max)
+			count = max;
+		first = ring_seq - count;
+		for (i = 0; i < count; i++)
+			entries[i] = ring[(first + i) & (TRACE_RING - 1)];
+		restore_flags(flags);
+		return count;
+
+	case TRACE_HIST:
+		if (nbytes < sizeof(trace_hist_t))
+			return -1;
+		cli_and_save(flags);
+		memcpy(buf, &hist, sizeof(trace_hist_t));
+		restore_flags(flags);
+		return 0;
+
+	case TRACE_TASKS:
+		max = nbytes / sizeof(trace_task_t);
+		count = 0;
+		cli_and_save(flags);
+		for (i = 0; i < TRACE_PIDS && count < max; i++) {
+			for (nr = 0; nr < TRACE_CALLS; nr++) {
+				if (tasks[i].calls[nr] != 0) {
+					out[count++] = tasks[i];
+					break;
+				}
+			}
+		}
+		restore_flags(flags);
+		return count;
+	}
+	return -1;
+}
@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "types.h"
+#include "sysnum.h"
+
+#define TRACE_CALLS NUM_SYSCALLS // system call numbers 1 to TRACE_CALLS
+#define TRACE_BUCKETS 32 // latency bucket b counts calls of 2^b to 2^(b+1) - 1 cycles
+#define TRACE_RING 256   // recent calls kept, power of two
+#define TRACE_PIDS 256   // one counter row per pid, same as MAX_PROCESSES
+#define TRACE_CMD_LEN 32
+
+// sys_trace commands
+#define TRACE_OFF 0
+#define TRACE_ON 1    // clears everything and starts recording
+#define TRACE_READ 2  // recent calls, oldest first, buf is a trace_entry_t array
+#define TRACE_HIST 3  // latency histograms, buf is a trace_hist_t
+#define TRACE_TASKS 4 // per pid counts, buf is a trace_task_t array
+
+// one finished call
+typedef struct trace_entry {
+	uint32_t seq;    // calls recorded before this one
+	int32_t pid;
+	uint32_t nr;     // system call number
+	uint32_t args[3];
+	int32_t ret;
+	uint32_t cycles; // TSC cycles from entry to return, including time blocked
+} trace_entry_t;
+
+typedef struct trace_hist {
+	uint32_t calls[TRACE_CALLS];
+	uint64_t cycles[TRACE_CALLS];
+	uint32_t buckets[TRACE_CALLS][TRACE_BUCKETS];
+} trace_hist_t;
+
+// calls made by the program a pid last ran
+typedef struct trace_task {
+	int32_t pid;
+	uint8_t cmd[TRACE_CMD_LEN];
+	uint32_t calls[TRACE_CALLS];
+	uint64_t cycles[TRACE_CALLS];
+} trace_task_t;
+
+// checked by the system call linkage before calling the hooks
+extern int trace_enabled;
+
+// system call linkage hooks, nr counts from 0 like the jump table
+void trace_syscall_enter(uint32_t nr, uint32_t a, uint32_t b, uint32_t c);
+void trace_syscall_exit(int32_t ret);
+
+// a pid starts a new program, its counters start over
+void trace_task_start(int32_t pid, const uint8_t* cmd);
+
+// sys_trace, nbytes is the buffer size in bytes
+int32_t trace_control(int32_t cmd, void* buf, int32_t nbytes);
+
+#endif // TRACE_H
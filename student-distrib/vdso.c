@@ -0,0 +1,81 @@
+#include "vdso.h"
+#include "lib.h"
+#include "x86_desc.h"
+#include "paging.h"
+#include "frame.h"
+#include "clock.h"
+
+static vdso_data_t* vdso = NULL;
+
+/*
+ * vdso_init
+ * DESCRIPTION: Fills a frame with the clock's scale factors and maps it at
+ * VDSO_ADDR through its own page table. The directory entry is user but not
+ * writable, and alloc_new_process copies it into every process directory.
+ * The mapping is the same everywhere, so the PTE is global
+ * INPUTS: none
+ * SIDE EFFECTS: allocates two frames, changes the kernel page directory
+ * RETURN VALUE: 0 on success, -1 if out of memory
+ */
+int vdso_init() {
+	uint32_t* table;
+	uint32_t shift;
+	uint64_t mult;
+
+	vdso = (vdso_data_t*) frame_alloc(0);
+	table = (uint32_t*) frame_alloc(0);
+	if (vdso == NULL || table == NULL) {
+		frame_free((uint32_t) vdso, 0);
+		frame_free((uint32_t) table, 0);
+		vdso = NULL;
+		return -1;
+	}
+	memset(vdso, 0, PAGE_SIZE);
+	memset(table, 0, PAGE_SIZE);
+
+	// as many fraction bits as fit, 32 for a TSC faster than 1 GHz, 31 at exactly 1 GHz
+	for (shift = VDSO_MAX_SHIFT; shift > 0; shift--) {
+		mult = (uint64_t) NS_PER_MS << shift;
+		div64_32(&mult, clock_tsc_khz());
+		if ((mult >> 32) == 0)
+			break;
+	}
+	vdso->version = VDSO_VERSION;
+	vdso->tsc_khz = clock_tsc_khz();
+	vdso->ns_mult = (uint32_t) mult;
+	vdso->ns_shift = shift;
+	vdso->boot_tsc = clock_boot_tsc();
+	vdso->boot_time = clock_boot_time();
+	vdso->pid = -1;
+	vdso->term = -1;
+
+	table[(VDSO_ADDR >> PT_ADDR_OFFSET) & SMALL_MASK] = (uint32_t) vdso | GLOBAL | USER_SPACE | PRESENT;
+	page_directory[VDSO_PD] = (uint32_t) table | USER_SPACE | PRESENT;
+	return 0;
+}
+
+/*
+ * vdso_set_task
+ * DESCRIPTION: Publishes the task about to run. Single words, so a reader
+ * never sees half an update
+ * INPUTS: pid, term: the task's pid and terminal
+ * SIDE EFFECTS: writes the shared page
+ * RETURN VALUE: none
+ */
+void vdso_set_task(int32_t pid, int32_t term) {
+	if (vdso == NULL)
+		return;
+	vdso->pid = pid;
+	vdso->term = term;
+}
+
+/*
+ * vdso_data
+ * DESCRIPTION: Kernel address of the shared page
+ * INPUTS: none
+ * SIDE EFFECTS: none
+ * RETURN VALUE: the page, NULL before vdso_init
+ */
+vdso_data_t* vdso_data() {
+	return vdso;
+}
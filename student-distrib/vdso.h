@@ -0,0 +1,33 @@
+#ifndef VDSO_H
+#define VDSO_H
+
+#include "types.h"
+
+// read-only page every process sees, user code reads it without a system call
+#define VDSO_ADDR 0x08C00000 // 140 MB, between the program window and vidmap
+#define VDSO_PD (VDSO_ADDR >> 22)
+#define VDSO_VERSION 1
+#define VDSO_MAX_SHIFT 32 // ns_shift starts here and drops until ns_mult fits in 32 bits
+
+// layout user programs see at VDSO_ADDR, ece391syscall.h has a copy
+typedef struct vdso_data {
+	uint32_t version;
+	uint32_t tsc_khz;   // TSC cycles per ms
+	uint32_t ns_mult;   // TSC to ns scale, ns = cycles * ns_mult >> ns_shift
+	uint32_t ns_shift;
+	uint64_t boot_tsc;  // TSC at CLOCK_MONOTONIC 0
+	uint32_t boot_time; // wall clock at boot, seconds since 1970 UTC
+	int32_t pid;        // running task, rewritten on every switch
+	int32_t term;       // its terminal
+} vdso_data_t;
+
+// allocate the page and map it into the kernel directory processes copy, after clock_init
+int vdso_init();
+
+// publish the task about to run
+void vdso_set_task(int32_t pid, int32_t term);
+
+// the kernel's view of the page, NULL before vdso_init
+vdso_data_t* vdso_data();
+
+#endif // VDSO_H
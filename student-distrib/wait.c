@@ -0,0 +1,63 @@
+#include "wait.h"
+#include "pcb.h"
+#include "lib.h"
+#include "x86_desc.h"
+#include "scheduling.h"
+
+/*
+ * sleep_on
+ * DESCRIPTION: Takes the current task off the CPU until wake_up is called on wq.
+ * The caller checks its condition with interrupts off and sleeps in a loop, so a
+ * wake up between the check and the sleep cannot be lost. Before the base shells
+ * are running there is no task to block, so this just waits for an interrupt
+ * INPUTS: wq: queue the event's interrupt handler wakes
+ * SIDE EFFECTS: switches tasks, returns with interrupts off
+ * RETURN VALUE: none
+ */
+void sleep_on(wait_queue_t* wq) {
+	pcb_t* pcb;
+
+	cli();
+	if (!sched_running()) {
+		sti();
+		asm volatile ("hlt");
+		cli();
+		return;
+	}
+
+	pcb = get_pcb(pid);
+	pcb->state = TASK_BLOCKED;
+	pcb->run_next = NULL;
+	if (wq->tail)
+		wq->tail->run_next = pcb;
+	else
+		wq->head = pcb;
+	wq->tail = pcb;
+
+	schedule();
+	cli();
+}
+
+/*
+ * wake_up
+ * DESCRIPTION: Moves every task sleeping on wq to the run queue, boosted for
+ * having given up the CPU
+ * INPUTS: wq: queue to empty
+ * SIDE EFFECTS: changes the run queue
+ * RETURN VALUE: none
+ */
+void wake_up(wait_queue_t* wq) {
+	pcb_t* pcb;
+	pcb_t* next;
+	uint32_t flags;
+
+	cli_and_save(flags);
+	pcb = wq->head;
+	wq->head = NULL;
+	wq->tail = NULL;
+	for (; pcb; pcb = next) {
+		next = pcb->run_next;
+		sched_wake(pcb);
+	}
+	restore_flags(flags);
+}
@@ -0,0 +1,22 @@
+#ifndef WAIT_H
+#define WAIT_H
+
+#include "types.h"
+
+struct pcb;
+
+// tasks sleeping until an interrupt handler reports an event
+typedef struct wait_queue {
+	struct pcb* head;
+	struct pcb* tail;
+} wait_queue_t;
+
+#define WAIT_QUEUE_INIT { NULL, NULL }
+
+// block the current task on wq, call with interrupts off and recheck the condition after
+void sleep_on(wait_queue_t* wq);
+
+// make every task on wq runnable, safe from interrupt handlers
+void wake_up(wait_queue_t* wq);
+
+#endif // WAIT_H
@@ -132,12 +132,6 @@ extern tss_t tss;
 
 /* External page directory and table */
 extern uint32_t page_directory[PD_EN];
-extern uint32_t pd_p0[PD_EN];
-extern uint32_t pd_p1[PD_EN];
-extern uint32_t pd_p2[PD_EN];
-extern uint32_t pd_p3[PD_EN];
-extern uint32_t pd_p4[PD_EN];
-extern uint32_t pd_p5[PD_EN];
 extern uint32_t page_table[PD_EN];
 extern uint32_t page_table_vid[PD_EN];
 
@@ -0,0 +1,79 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define SECS_PER_DAY 86400
+#define NUMBUF 16
+
+/* print a number zero padded to width digits */
+static void put_num(uint32_t value, int32_t width)
+{
+    uint8_t buf[NUMBUF];
+    int32_t len;
+
+    ece391_itoa(value, buf, 10);
+    for (len = ece391_strlen(buf); len < width; len++)
+        ece391_fdputs(1, (uint8_t*)"0");
+    ece391_fdputs(1, buf);
+}
+
+/* print days since 1970 as YYYY-MM-DD (civil calendar, March first) */
+static void put_date(uint32_t days)
+{
+    uint32_t era, doe, yoe, doy, mp, year, month, day;
+
+    days += 719468;
+    era = days / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = (mp < 10) ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2);
+
+    put_num(year, 4);
+    ece391_fdputs(1, (uint8_t*)"-");
+    put_num(month, 2);
+    ece391_fdputs(1, (uint8_t*)"-");
+    put_num(day, 2);
+}
+
+int main ()
+{
+    timespec_t wall, up, again;
+    uint32_t secs, cost;
+    uint64_t t0, t1;
+
+    if (ece391_gettime(CLOCK_REALTIME, &wall) == -1 || ece391_gettime(CLOCK_MONOTONIC, &up) == -1) {
+        ece391_fdputs(1, (uint8_t*)"Can't read the clock.\n");
+        return 2;
+    }
+    ece391_gettime(CLOCK_MONOTONIC, &again);
+    t0 = ece391_clock_ns();
+    t1 = ece391_clock_ns();
+
+    put_date(wall.sec / SECS_PER_DAY);
+    secs = wall.sec % SECS_PER_DAY;
+    ece391_fdputs(1, (uint8_t*)" ");
+    put_num(secs / 3600, 2);
+    ece391_fdputs(1, (uint8_t*)":");
+    put_num(secs / 60 % 60, 2);
+    ece391_fdputs(1, (uint8_t*)":");
+    put_num(secs % 60, 2);
+    ece391_fdputs(1, (uint8_t*)".");
+    put_num(wall.nsec, 9);
+    ece391_fdputs(1, (uint8_t*)" UTC\nup ");
+    put_num(up.sec, 1);
+    ece391_fdputs(1, (uint8_t*)".");
+    put_num(up.nsec, 9);
+    ece391_fdputs(1, (uint8_t*)" s, gettime takes ");
+    cost = (again.sec - up.sec) * 1000000000 + again.nsec - up.nsec;
+    put_num(cost, 1);
+    ece391_fdputs(1, (uint8_t*)" ns, the vdso ");
+    put_num((uint32_t)(t1 - t0), 1);
+    ece391_fdputs(1, (uint8_t*)" ns\n");
+
+    return 0;
+}
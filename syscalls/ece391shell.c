@@ -5,9 +5,32 @@
 
 #define BUFSIZE 1024
 
+/* a | b: a writes into a pipe that b reads, both run at once */
+static int32_t run_pipeline (uint8_t* left, uint8_t* right)
+{
+    int32_t fds[2];
+    int32_t writer, reader, rval;
+
+    if (-1 == ece391_pipe (fds)) {
+        ece391_fdputs (1, (uint8_t*)"could not create pipe\n");
+        return 0;
+    }
+    writer = ece391_spawn (left, 0, fds[1]);
+    reader = ece391_spawn (right, fds[0], 1);
+    /* the shell's own ends would keep the reader from seeing end of file */
+    ece391_close (fds[0]);
+    ece391_close (fds[1]);
+
+    rval = (-1 == reader) ? -1 : ece391_wait (reader);
+    if (-1 == writer)
+        return -1;
+    ece391_wait (writer);
+    return rval;
+}
+
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt, rval, bar;
     uint8_t buf[BUFSIZE];
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
@@ -24,7 +47,14 @@ int main ()
 	    return 0;
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
+	for (bar = 0; '\0' != buf[bar] && '|' != buf[bar]; bar++)
+	    ;
+	if ('|' == buf[bar]) {
+	    buf[bar] = '\0';
+	    rval = run_pipeline (buf, buf + bar + 1);
+	} else {
+	    rval = ece391_execute (buf);
+	}
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
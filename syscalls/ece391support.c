@@ -21,6 +21,21 @@ void ece391_fdputs(int32_t fd, const uint8_t* s)
     (void)ece391_write (fd, s, ece391_strlen(s));
 }
 
+/* write n strings with one system call, at most IOV_MAX of them */
+void ece391_fdputsv(int32_t fd, const uint8_t* const* s, int32_t n)
+{
+    iovec_t iov[IOV_MAX];
+    int32_t i;
+
+    if (n > IOV_MAX)
+        n = IOV_MAX;
+    for (i = 0; i < n; i++) {
+        iov[i].base = (void*)s[i];
+        iov[i].len = ece391_strlen(s[i]);
+    }
+    (void)ece391_writev (fd, iov, n);
+}
+
 int32_t ece391_strcmp(const uint8_t* s1, const uint8_t* s2)
 {
     while (*s1 == *s2) {
@@ -102,3 +117,105 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+
+/* cycles * mult >> shift without overflowing, one 32x32 multiply per half */
+static uint64_t scale(uint64_t cycles, uint32_t mult, uint32_t shift)
+{
+    uint64_t lo = (uint64_t)(uint32_t)cycles * mult;
+    uint64_t hi = (uint64_t)(uint32_t)(cycles >> 32) * mult;
+
+    return (hi << (32 - shift)) + (lo >> shift);
+}
+
+/* divide *n by d in place (no libgcc for 64 bit division), returns the remainder */
+static uint32_t div64_32(uint64_t* n, uint32_t d)
+{
+    uint32_t hi = (uint32_t)(*n >> 32), lo = (uint32_t)*n, rem;
+    uint32_t q_hi = hi / d;
+
+    asm ("divl %4"
+         : "=a"(lo), "=d"(rem)
+         : "a"(lo), "d"(hi % d), "rm"(d));
+    *n = ((uint64_t)q_hi << 32) | lo;
+    return rem;
+}
+
+uint64_t ece391_rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+uint64_t ece391_clock_ns(void)
+{
+    const volatile vdso_data_t* vdso = (const volatile vdso_data_t*)VDSO_ADDR;
+
+    return scale(ece391_rdtsc() - vdso->boot_tsc, vdso->ns_mult, vdso->ns_shift);
+}
+
+uint32_t ece391_cycles_to_us(uint64_t cycles)
+{
+    const volatile vdso_data_t* vdso = (const volatile vdso_data_t*)VDSO_ADDR;
+    uint64_t ns = scale(cycles, vdso->ns_mult, vdso->ns_shift);
+
+    div64_32(&ns, 1000);
+    return (uint32_t)ns;
+}
+
+int32_t ece391_clock_gettime(uint32_t clock_id, struct timespec* ts)
+{
+    const volatile vdso_data_t* vdso = (const volatile vdso_data_t*)VDSO_ADDR;
+    uint64_t now;
+
+    if (clock_id != CLOCK_MONOTONIC && clock_id != CLOCK_REALTIME)
+        return -1;
+    now = ece391_clock_ns();
+    ts->nsec = div64_32(&now, 1000000000);
+    ts->sec = (uint32_t)now;
+    if (clock_id == CLOCK_REALTIME)
+        ts->sec += vdso->boot_time;
+    return 0;
+}
+
+int32_t ece391_getpid(void)
+{
+    return ((const volatile vdso_data_t*)VDSO_ADDR)->pid;
+}
+
+int32_t ece391_getterm(void)
+{
+    return ((const volatile vdso_data_t*)VDSO_ADDR)->term;
+}
+
+/* queue one submission, -1 if the submission queue is full */
+int32_t ece391_ring_prep(io_ring_t* ring, uint32_t op, int32_t fd, void* buf, int32_t nbytes, uint32_t user_data)
+{
+    ring_sqe_t* sqe;
+
+    if (ring->sq_tail - ring->sq_head >= ring->entries)
+        return -1;
+    sqe = &ring->sqes[ring->sq_tail & (ring->entries - 1)];
+    sqe->op = op;
+    sqe->fd = fd;
+    sqe->buf = (uint32_t)buf;
+    sqe->nbytes = nbytes;
+    sqe->user_data = user_data;
+    ring->sq_tail++;
+    return 0;
+}
+
+/* take the oldest completion, -1 if there is none */
+int32_t ece391_ring_reap(io_ring_t* ring, uint32_t* user_data, int32_t* res)
+{
+    ring_cqe_t* cqe;
+
+    if (ring->cq_head == *(volatile uint32_t*)&ring->cq_tail)
+        return -1;
+    cqe = &ring->cqes[ring->cq_head & (ring->entries - 1)];
+    *user_data = cqe->user_data;
+    *res = cqe->res;
+    ring->cq_head++;
+    return 0;
+}
@@ -4,10 +4,25 @@
 extern uint32_t ece391_strlen(const uint8_t* s);
 extern void ece391_strcpy(uint8_t* dst, const uint8_t* src);
 extern void ece391_fdputs(int32_t fd, const uint8_t* s);
+extern void ece391_fdputsv(int32_t fd, const uint8_t* const* s, int32_t n);
 extern int32_t ece391_strcmp(const uint8_t* s1, const uint8_t* s2);
 extern int32_t ece391_strncmp(const uint8_t* s1, const uint8_t* s2, uint32_t n);
 extern uint8_t *ece391_itoa(uint32_t value, uint8_t* buf, int32_t radix);
 extern uint8_t *ece391_strrev(uint8_t* s);
 
+/* Read the kernel's shared page, no system call */
+struct timespec;
+extern uint64_t ece391_rdtsc(void);
+extern uint64_t ece391_clock_ns(void);
+extern uint32_t ece391_cycles_to_us(uint64_t cycles);
+extern int32_t ece391_clock_gettime(uint32_t clock_id, struct timespec* ts);
+extern int32_t ece391_getpid(void);
+extern int32_t ece391_getterm(void);
+
+/* Queue and reap ring entries, ece391_ring_enter runs the queue */
+struct io_ring;
+extern int32_t ece391_ring_prep(struct io_ring* ring, uint32_t op, int32_t fd, void* buf, int32_t nbytes, uint32_t user_data);
+extern int32_t ece391_ring_reap(struct io_ring* ring, uint32_t* user_data, int32_t* res);
+
 #endif /* ECE391SUPPORT_H */
 
@@ -0,0 +1,116 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define ROUNDS_SHIFT 17
+#define ROUNDS (1 << ROUNDS_SHIFT)
+#define NUMBUF 16
+#define BATCH_SHIFT 6
+#define BATCH (1 << BATCH_SHIFT)
+#define BATCH_ROUNDS_SHIFT (ROUNDS_SHIFT - BATCH_SHIFT)
+#define CHUNK 1024
+#define READ_FILE "shell"
+
+static io_ring_t ring;
+static uint8_t chunks[BATCH][CHUNK];
+
+/* print a number followed by a string */
+static void put_num(uint32_t value, const char* after)
+{
+    uint8_t buf[NUMBUF];
+
+    ece391_itoa(value, buf, 10);
+    ece391_fdputs(1, buf);
+    ece391_fdputs(1, (uint8_t*)after);
+}
+
+/* average cycles and ns for one null call through entry */
+static void bench(const char* name, int32_t (*entry)(void))
+{
+    uint64_t start_ns, start_tsc, ns, cycles;
+    int32_t i;
+
+    start_ns = ece391_clock_ns();
+    start_tsc = ece391_rdtsc();
+    for (i = 0; i < ROUNDS; i++)
+        entry();
+    cycles = ece391_rdtsc() - start_tsc;
+    ns = ece391_clock_ns() - start_ns;
+
+    ece391_fdputs(1, (uint8_t*)name);
+    /* a power of two rounds, so no 64 bit divide */
+    put_num((uint32_t)(cycles >> ROUNDS_SHIFT), " cycles, ");
+    put_num((uint32_t)(ns >> ROUNDS_SHIFT), " ns per call\n");
+}
+
+/* the same number of null calls as bench, but BATCH per ring_enter */
+static void bench_ring(void)
+{
+    uint64_t start_tsc, cycles;
+    uint32_t data;
+    int32_t i, j, res;
+
+    start_tsc = ece391_rdtsc();
+    for (i = 0; i < (1 << BATCH_ROUNDS_SHIFT); i++) {
+        for (j = 0; j < BATCH; j++)
+            ece391_ring_prep(&ring, RING_OP_NOP, 0, 0, 0, j);
+        ece391_ring_enter(BATCH);
+        while (ece391_ring_reap(&ring, &data, &res) == 0)
+            ;
+    }
+    cycles = ece391_rdtsc() - start_tsc;
+
+    ece391_fdputs(1, (uint8_t*)"ring nop:  ");
+    put_num((uint32_t)(cycles >> ROUNDS_SHIFT), " cycles per entry, ");
+    put_num(BATCH, " per ring_enter\n");
+}
+
+/* read up to BATCH chunks of a file with one call each, then in one batch */
+static void bench_read(void)
+{
+    uint64_t start_tsc, plain, batched;
+    uint32_t data;
+    int32_t fd, i, res, bytes;
+
+    fd = ece391_open((uint8_t*)READ_FILE);
+    if (fd == -1)
+        return;
+    start_tsc = ece391_rdtsc();
+    for (i = 0; i < BATCH && ece391_read(fd, chunks[i], CHUNK) > 0; i++)
+        ;
+    plain = ece391_rdtsc() - start_tsc;
+    ece391_close(fd);
+
+    fd = ece391_open((uint8_t*)READ_FILE);
+    start_tsc = ece391_rdtsc();
+    for (i = 0; i < BATCH; i++)
+        ece391_ring_prep(&ring, RING_OP_READ, fd, chunks[i], CHUNK, i);
+    ece391_ring_enter(BATCH);
+    bytes = 0;
+    while (ece391_ring_reap(&ring, &data, &res) == 0) {
+        if (res > 0)
+            bytes += res;
+    }
+    batched = ece391_rdtsc() - start_tsc;
+    ece391_close(fd);
+
+    ece391_fdputs(1, (uint8_t*)READ_FILE ", ");
+    put_num(bytes, " bytes in 1K reads: ");
+    put_num((uint32_t)plain, " cycles one by one, ");
+    put_num((uint32_t)batched, " cycles batched\n");
+}
+
+int main ()
+{
+    bench("int $0x80: ", ece391_null_int80);
+    if (ece391_has_sysenter())
+        bench("sysenter:  ", ece391_null_sysenter);
+    else
+        ece391_fdputs(1, (uint8_t*)"sysenter:  not supported by this CPU\n");
+    if (ece391_ring_setup(&ring, BATCH) == 0) {
+        bench_ring();
+        bench_read();
+    }
+    return 0;
+}
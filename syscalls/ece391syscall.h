@@ -3,8 +3,148 @@
 
 #include <stdint.h>
 
+#include "ece391sysnum.h"
+
 /* All calls return >= 0 on success or -1 on failure. */
 
+#define STATS_MAX_TASKS 16
+#define STATS_CMD_LEN 32
+
+/* Task states reported by ece391_stats */
+#define TASK_RUNNING 0
+#define TASK_RUNNABLE 1
+#define TASK_WAITING 2
+#define TASK_BLOCKED 3
+#define TASK_ZOMBIE 4	/* spawned, halted, not yet waited for */
+
+/* Per task counters, CPU times are TSC cycles */
+typedef struct task_stats {
+	uint64_t user_cycles;
+	uint64_t kernel_cycles;
+	uint64_t wait_cycles;	/* runnable, waiting for the CPU */
+	uint32_t voluntary;	/* switched away because it blocked */
+	uint32_t involuntary;	/* switched away because it was preempted */
+} task_stats_t;
+
+typedef struct task_info {
+	int32_t pid;
+	int32_t parent_id;
+	int32_t term;
+	int32_t state;
+	int32_t priority;
+	uint8_t cmd[STATS_CMD_LEN];
+	task_stats_t stats;
+} task_info_t;
+
+/* Filled in by ece391_stats, which returns the number of tasks */
+typedef struct sched_info {
+	uint64_t now;
+	uint64_t idle_cycles;
+	uint32_t switches;
+	uint32_t switch_cycles_last;
+	uint32_t switch_cycles_avg;
+	uint32_t timer_interrupts;
+	uint32_t task_count;
+	task_info_t tasks[STATS_MAX_TASKS];
+} sched_info_t;
+
+/* Clocks for ece391_gettime */
+#define CLOCK_MONOTONIC 0	/* time since boot */
+#define CLOCK_REALTIME 1	/* wall clock, seconds since 1970 UTC */
+
+typedef struct timespec {
+	uint32_t sec;
+	uint32_t nsec;
+} timespec_t;
+
+/* Read-only page the kernel maps into every program, ece391support.c reads it */
+#define VDSO_ADDR 0x08C00000
+
+typedef struct vdso_data {
+	uint32_t version;
+	uint32_t tsc_khz;	/* TSC cycles per ms */
+	uint32_t ns_mult;	/* ns = cycles * ns_mult >> ns_shift */
+	uint32_t ns_shift;
+	uint64_t boot_tsc;	/* TSC at CLOCK_MONOTONIC 0 */
+	uint32_t boot_time;	/* wall clock at boot, seconds since 1970 UTC */
+	int32_t pid;		/* the running program */
+	int32_t term;		/* its terminal */
+} vdso_data_t;
+
+/* System call tracing, see ece391_trace */
+#define TRACE_CALLS NUM_SYSCALLS
+#define TRACE_BUCKETS 32	/* bucket b counts calls of 2^b to 2^(b+1) - 1 cycles */
+#define TRACE_RING 256
+#define TRACE_CMD_LEN 32
+
+#define TRACE_OFF 0
+#define TRACE_ON 1	/* clears everything and starts recording */
+#define TRACE_READ 2	/* recent calls, oldest first, into a trace_entry_t array */
+#define TRACE_HIST 3	/* latency histograms, into a trace_hist_t */
+#define TRACE_TASKS 4	/* per pid counts, into a trace_task_t array */
+
+typedef struct trace_entry {
+	uint32_t seq;
+	int32_t pid;
+	uint32_t nr;
+	uint32_t args[3];
+	int32_t ret;
+	uint32_t cycles;	/* entry to return, including time blocked */
+} trace_entry_t;
+
+typedef struct trace_hist {
+	uint32_t calls[TRACE_CALLS];
+	uint64_t cycles[TRACE_CALLS];
+	uint32_t buckets[TRACE_CALLS][TRACE_BUCKETS];
+} trace_hist_t;
+
+typedef struct trace_task {
+	int32_t pid;
+	uint8_t cmd[TRACE_CMD_LEN];
+	uint32_t calls[TRACE_CALLS];
+	uint64_t cycles[TRACE_CALLS];
+} trace_task_t;
+
+/* Pieces of a buffer for ece391_readv and ece391_writev */
+#define IOV_MAX 16
+#define IOV_MAX_BYTES 0x1000	/* longer vectors get a short read or write */
+
+typedef struct iovec {
+	void* base;
+	uint32_t len;
+} iovec_t;
+
+/* Submission/completion ring, see ece391_ring_setup and ece391support.c */
+#define RING_MAX_ENTRIES 64
+
+#define RING_OP_NOP 0
+#define RING_OP_READ 1	/* ece391_read(fd, buf, nbytes) */
+#define RING_OP_WRITE 2	/* ece391_write(fd, buf, nbytes) */
+
+typedef struct ring_sqe {
+	uint32_t op;
+	int32_t fd;
+	uint32_t buf;
+	int32_t nbytes;
+	uint32_t user_data;	/* handed back in the completion */
+} ring_sqe_t;
+
+typedef struct ring_cqe {
+	uint32_t user_data;
+	int32_t res;	/* what the call would have returned */
+} ring_cqe_t;
+
+/* the program fills sqes and moves sq_tail and cq_head, the kernel the rest */
+typedef struct io_ring {
+	uint32_t sq_head;
+	uint32_t sq_tail;
+	uint32_t cq_head;
+	uint32_t cq_tail;
+	uint32_t entries;
+	ring_sqe_t sqes[RING_MAX_ENTRIES];
+	ring_cqe_t cqes[RING_MAX_ENTRIES];
+} io_ring_t;
+
 /*  
  * Note that the system call for halt will have to make sure that only
  * the low byte of EBX (the status argument) is returned to the calling
@@ -21,6 +161,29 @@ extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
+extern int32_t ece391_stats (sched_info_t* info);
+extern int32_t ece391_yield (void);
+extern int32_t ece391_sleep (uint32_t ms);
+extern int32_t ece391_gettime (uint32_t clock_id, timespec_t* ts);
+extern int32_t ece391_trace (int32_t cmd, void* buf, int32_t nbytes);
+extern int32_t ece391_ring_setup (io_ring_t* ring, uint32_t entries);
+extern int32_t ece391_ring_enter (uint32_t to_submit);
+extern int32_t ece391_readv (int32_t fd, const iovec_t* iov, int32_t iovcnt);
+extern int32_t ece391_writev (int32_t fd, const iovec_t* iov, int32_t iovcnt);
+
+/* fds[0] is the read end, fds[1] the write end. A spawned program runs
+   alongside its parent, with in_fd and out_fd as its 0 and 1, and wait
+   returns what execute would have */
+extern int32_t ece391_pipe (int32_t* fds);
+extern int32_t ece391_spawn (const uint8_t* command, int32_t in_fd, int32_t out_fd);
+extern int32_t ece391_wait (int32_t pid);
+extern int32_t ece391_isatty (int32_t fd);
+
+/* Entry path, SYSENTER if CPUID has SEP, and unused call numbers through
+   each path for timing the entry and exit alone (they return -1) */
+extern int32_t ece391_has_sysenter (void);
+extern int32_t ece391_null_int80 (void);
+extern int32_t ece391_null_sysenter (void);
 
 enum signums {
 	DIV_ZERO = 0,
@@ -7,6 +7,8 @@
 #define BIG_FD 1073741823
 #define BIG_NUM 1073741823
 #define NEG_NUM -1073741823
+#define NAP_MS 100
+#define ORPHAN_POLLS 20
 
 /* call_sys
  * This function calls the system call #(num)
@@ -292,6 +294,75 @@ int err_vidmap(void) {
 	return fail;
  }
 
+/* orphan_parent
+ * the copy of this program err_orphan spawns: spawns a napping grandchild
+ * and halts straight away, leaving it without a parent
+ * returns the grandchild's PID, 0 if it could not be spawned
+ */
+int orphan_parent(void)
+{
+	int32_t child = ece391_spawn((uint8_t*)"syserr nap", 0, 1);
+
+	return (-1 == child) ? 0 : child;
+}
+
+/* TEST 9 err_orphan
+ * spawns a copy of this program whose own spawned child outlives it, then
+ * checks that child's PID is freed once it halts although nobody waits for
+ * it, and that a new spawn can get the PID back
+ * prints "[TEST_NAME]: PASS" if behavior is EXPECTED
+ *     and then returns 0
+ * prints "[TEST_NAME]: FAIL" if behavior is UNEXPECTED
+ *     and then returns 2
+ */
+int err_orphan(void)
+{
+	static sched_info_t info;
+	int32_t mid, orphan, again[2];
+	int32_t i, j, n, found = 1;
+	int fail = 0;
+
+	mid = ece391_spawn((uint8_t*)"syserr orphan", 0, 1);
+	orphan = (-1 == mid) ? 0 : ece391_wait(mid);
+	if (orphan <= 0) {
+		ece391_fdputs (1, (uint8_t*)"spawn fail\n");
+		fail = 2;
+	}
+	for (i = 0; !fail && found && i < ORPHAN_POLLS; i++) {
+		ece391_sleep(NAP_MS);
+		n = ece391_stats(&info);
+		found = 0;
+		for (j = 0; j < n; j++) {
+			if (info.tasks[j].pid == orphan)
+				found = 1;
+		}
+	}
+	if (!fail && found) {
+		ece391_fdputs (1, (uint8_t*)"orphan not freed\n");
+		fail = 2;
+	}
+	if (!fail) {
+		again[0] = ece391_spawn((uint8_t*)"syserr nap", 0, 1);
+		again[1] = ece391_spawn((uint8_t*)"syserr nap", 0, 1);
+		if (again[0] != orphan && again[1] != orphan) {
+			ece391_fdputs (1, (uint8_t*)"orphan pid not reused\n");
+			fail = 2;
+		}
+		for (j = 0; j < 2; j++) {
+			if (-1 != again[j])
+				ece391_wait(again[j]);
+		}
+	}
+
+	if (fail) {
+		ece391_fdputs (1, (uint8_t*)"err_orphan: FAIL\n");
+	} else {
+		ece391_fdputs (1, (uint8_t*)"err_orphan: PASS\n");
+	}
+
+	return fail;
+}
+
 
 int main ()
 {
@@ -299,7 +370,17 @@ int main ()
     uint8_t buf[128];
 	int fail = 0;
 
-    ece391_fdputs (1, (uint8_t*)"Choose from tests 1-8. 0 to run all: ");
+	/* err_orphan runs copies of this program with an argument */
+	if (0 == ece391_getargs (buf, 128)) {
+		if (0 == ece391_strcmp (buf, (uint8_t*)"orphan"))
+			return orphan_parent();
+		if (0 == ece391_strcmp (buf, (uint8_t*)"nap")) {
+			ece391_sleep (NAP_MS);
+			return 0;
+		}
+	}
+
+    ece391_fdputs (1, (uint8_t*)"Choose from tests 1-9. 0 to run all: ");
     if (-1 == (cnt = ece391_read (0, buf, 127))) {
         ece391_fdputs (1, (uint8_t*)"Can't read test #\n");
 		return 2;
@@ -316,6 +397,7 @@ int main ()
 			fail += err_vidmap();
 			fail += err_stdin_out();
 			fail += err_syscall_num();
+			fail += err_orphan();
 			if(fail) {
 				ece391_fdputs (1, (uint8_t*)"\nOverall Tests: FAIL\n");
 			} else {
@@ -338,8 +420,10 @@ int main ()
 			return err_stdin_out();
 		case 8:
 			return err_syscall_num();
+		case 9:
+			return err_orphan();
 		default:
-			ece391_fdputs (1, (uint8_t*)"Invalid test number. Choose from tests 1-8 or 0");
+			ece391_fdputs (1, (uint8_t*)"Invalid test number. Choose from tests 1-9 or 0");
 			break;
 	}
     return 0;
@@ -11,5 +11,21 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_STATS  11
+#define SYS_YIELD  12
+#define SYS_SLEEP  13
+#define SYS_GETTIME  14
+#define SYS_TRACE  15
+#define SYS_RING_SETUP  16
+#define SYS_RING_ENTER  17
+#define SYS_READV  18
+#define SYS_WRITEV  19
+#define SYS_PIPE  20
+#define SYS_SPAWN  21
+#define SYS_WAIT  22
+#define SYS_ISATTY  23
+
+/* calls are numbered from 1, keep this the last one */
+#define NUM_SYSCALLS SYS_ISATTY
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,118 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define REFRESHES 10
+#define REFRESH_MS 1000
+#define PERCENT 100
+#define PERCENT_SCALE 0xFFFFFF
+#define NUMBUF 16
+
+static sched_info_t snap[2];
+static const char* state_names[] = { "RUN ", "RDY ", "WAIT", "BLK ", "ZOMB" };
+
+/* part of whole in percent, scaled down first since there is no 64 bit divide */
+static uint32_t percent(uint64_t part, uint64_t whole)
+{
+    while (whole > PERCENT_SCALE) {
+        whole >>= 1;
+        part >>= 1;
+    }
+    if (whole == 0)
+        return 0;
+    return (uint32_t)part * PERCENT / (uint32_t)whole;
+}
+
+/* print a number right aligned in width columns */
+static void put_num(uint32_t value, int32_t width)
+{
+    uint8_t buf[NUMBUF];
+    int32_t len;
+
+    ece391_itoa(value, buf, 10);
+    for (len = ece391_strlen(buf); len < width; len++)
+        ece391_fdputs(1, (uint8_t*)" ");
+    ece391_fdputs(1, buf);
+}
+
+/* counter growth since the last snapshot, a reused pid starts from zero */
+static uint64_t delta(uint64_t cur, uint64_t prev)
+{
+    return (cur >= prev) ? cur - prev : cur;
+}
+
+/* the same pid in the previous snapshot, NULL if it is new */
+static task_info_t* find_task(sched_info_t* info, int32_t pid)
+{
+    uint32_t i;
+
+    for (i = 0; i < info->task_count; i++) {
+        if (info->tasks[i].pid == pid)
+            return &info->tasks[i];
+    }
+    return 0;
+}
+
+static void show(sched_info_t* cur, sched_info_t* prev)
+{
+    static task_info_t none;
+    uint64_t span = cur->now - prev->now;
+    uint64_t user, kernel;
+    task_info_t* t;
+    task_info_t* p;
+    uint32_t i;
+
+    ece391_fdputs(1, (uint8_t*)"\nbusy%");
+    put_num(PERCENT - percent(delta(cur->idle_cycles, prev->idle_cycles), span), 4);
+    ece391_fdputs(1, (uint8_t*)"  switches");
+    put_num(cur->switches - prev->switches, 6);
+    ece391_fdputs(1, (uint8_t*)"  avg switch cycles");
+    put_num(cur->switch_cycles_avg, 8);
+    ece391_fdputs(1, (uint8_t*)"  timer irqs");
+    put_num(cur->timer_interrupts - prev->timer_interrupts, 5);
+    ece391_fdputs(1, (uint8_t*)"\n  PID TERM PRI STATE CPU% USR% SYS% WAIT%   VOL INVOL CMD\n");
+
+    for (i = 0; i < cur->task_count; i++) {
+        t = &cur->tasks[i];
+        p = find_task(prev, t->pid);
+        if (p == 0)
+            p = &none;
+        user = delta(t->stats.user_cycles, p->stats.user_cycles);
+        kernel = delta(t->stats.kernel_cycles, p->stats.kernel_cycles);
+
+        put_num(t->pid, 5);
+        put_num(t->term, 5);
+        put_num(t->priority, 4);
+        ece391_fdputs(1, (uint8_t*)"  ");
+        ece391_fdputs(1, (uint8_t*)((t->state >= 0 && t->state <= TASK_ZOMBIE) ? state_names[t->state] : "?   "));
+        put_num(percent(user + kernel, span), 5);
+        put_num(percent(user, span), 5);
+        put_num(percent(kernel, span), 5);
+        put_num(percent(delta(t->stats.wait_cycles, p->stats.wait_cycles), span), 6);
+        put_num(t->stats.voluntary - p->stats.voluntary, 6);
+        put_num(t->stats.involuntary - p->stats.involuntary, 6);
+        ece391_fdputs(1, (uint8_t*)" ");
+        ece391_fdputs(1, t->cmd);
+        ece391_fdputs(1, (uint8_t*)"\n");
+    }
+}
+
+int main ()
+{
+    int32_t i;
+
+    if (ece391_stats(&snap[0]) == -1) {
+        ece391_fdputs(1, (uint8_t*)"Can't read scheduler stats.\n");
+        return 3;
+    }
+
+    /* one table per second, covering that second */
+    for (i = 1; i <= REFRESHES; i++) {
+        ece391_sleep(REFRESH_MS);
+        ece391_stats(&snap[i & 1]);
+        show(&snap[i & 1], &snap[(i + 1) & 1]);
+    }
+
+    return 0;
+}
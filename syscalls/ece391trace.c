@@ -0,0 +1,131 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define ARGLEN 128 // getargs wants room for the whole argument buffer
+#define NUMBUF 16
+#define MAX_TASKS 16
+#define SHOW_RECENT 10
+
+static const char* call_names[TRACE_CALLS + 1] = {
+    "?", "halt", "execute", "read", "write", "open", "close", "getargs", "vidmap",
+    "set_handler", "sigreturn", "stats", "yield", "sleep", "gettime", "trace",
+    "ring_setup", "ring_enter", "readv", "writev",
+    "pipe", "spawn", "wait", "isatty"
+};
+
+static trace_task_t tasks[MAX_TASKS];
+static trace_hist_t hist;
+static trace_entry_t recent[SHOW_RECENT];
+
+/* print a number right aligned in width columns */
+static void put_num(uint32_t value, int32_t width, int32_t radix)
+{
+    uint8_t buf[NUMBUF];
+    int32_t len;
+
+    ece391_itoa(value, buf, radix);
+    for (len = ece391_strlen(buf); len < width; len++)
+        ece391_fdputs(1, (uint8_t*)" ");
+    ece391_fdputs(1, buf);
+}
+
+static void put_name(uint32_t nr)
+{
+    ece391_fdputs(1, (uint8_t*)((nr <= TRACE_CALLS) ? call_names[nr] : call_names[0]));
+}
+
+/* per program: calls made and time spent in each */
+static void show_tasks(void)
+{
+    int32_t count, i, nr;
+
+    count = ece391_trace(TRACE_TASKS, tasks, sizeof(tasks));
+    ece391_fdputs(1, (uint8_t*)"PID CMD        CALL        COUNT      US\n");
+    for (i = 0; i < count; i++) {
+        for (nr = 0; nr < TRACE_CALLS; nr++) {
+            if (tasks[i].calls[nr] == 0)
+                continue;
+            put_num(tasks[i].pid, 3, 10);
+            ece391_fdputs(1, (uint8_t*)" ");
+            ece391_fdputs(1, tasks[i].cmd);
+            ece391_fdputs(1, (uint8_t*)"  ");
+            put_name(nr + 1);
+            put_num(tasks[i].calls[nr], 8, 10);
+            put_num(ece391_cycles_to_us(tasks[i].cycles[nr]), 8, 10);
+            ece391_fdputs(1, (uint8_t*)"\n");
+        }
+    }
+}
+
+/* per call: how many calls landed in each power of two of cycles */
+static void show_hist(void)
+{
+    int32_t nr, b;
+
+    if (ece391_trace(TRACE_HIST, &hist, sizeof(hist)) == -1)
+        return;
+    ece391_fdputs(1, (uint8_t*)"latency, log2 cycles:count\n");
+    for (nr = 0; nr < TRACE_CALLS; nr++) {
+        if (hist.calls[nr] == 0)
+            continue;
+        put_name(nr + 1);
+        ece391_fdputs(1, (uint8_t*)":");
+        for (b = 0; b < TRACE_BUCKETS; b++) {
+            if (hist.buckets[nr][b] == 0)
+                continue;
+            put_num(b, 3, 10);
+            ece391_fdputs(1, (uint8_t*)":");
+            put_num(hist.buckets[nr][b], 1, 10);
+        }
+        ece391_fdputs(1, (uint8_t*)"\n");
+    }
+}
+
+/* the last few calls with their arguments */
+static void show_recent(void)
+{
+    int32_t count, i, a;
+
+    count = ece391_trace(TRACE_READ, recent, sizeof(recent));
+    ece391_fdputs(1, (uint8_t*)"recent calls\n");
+    for (i = 0; i < count; i++) {
+        put_num(recent[i].pid, 3, 10);
+        ece391_fdputs(1, (uint8_t*)" ");
+        put_name(recent[i].nr);
+        ece391_fdputs(1, (uint8_t*)"(");
+        for (a = 0; a < 3; a++) {
+            ece391_fdputs(1, (uint8_t*)(a ? ", 0x" : "0x"));
+            put_num(recent[i].args[a], 1, 16);
+        }
+        ece391_fdputs(1, (uint8_t*)") = ");
+        if (recent[i].ret < 0) {
+            ece391_fdputs(1, (uint8_t*)"-");
+            put_num(-recent[i].ret, 1, 10);
+        } else {
+            put_num(recent[i].ret, 1, 10);
+        }
+        put_num(recent[i].cycles, 10, 10);
+        ece391_fdputs(1, (uint8_t*)" cycles\n");
+    }
+}
+
+int main ()
+{
+    uint8_t arg[ARGLEN];
+
+    if (ece391_getargs(arg, ARGLEN) == 0) {
+        if (ece391_strcmp(arg, (uint8_t*)"on") == 0)
+            return (ece391_trace(TRACE_ON, 0, 0) == -1) ? 2 : 0;
+        if (ece391_strcmp(arg, (uint8_t*)"off") == 0)
+            return (ece391_trace(TRACE_OFF, 0, 0) == -1) ? 2 : 0;
+        ece391_fdputs(1, (uint8_t*)"usage: trace [on|off]\n");
+        return 3;
+    }
+
+    show_tasks();
+    show_hist();
+    show_recent();
+    return 0;
+}